@@ -14,7 +14,7 @@ void LCD_Init(void)
          .miso_io_num = EXAMPLE_PIN_NUM_MISO,                                            
          .quadwp_io_num = -1,                                                             
          .quadhd_io_num = -1,                                                             
-         .max_transfer_sz = EXAMPLE_LCD_H_RES * EXAMPLE_LCD_V_RES * sizeof(uint16_t),    
+         .max_transfer_sz = LVGL_DMA_CHUNK_BYTES,                                        // larger flushes are split into queued chunks of this size
      };
     ESP_ERROR_CHECK(spi_bus_initialize(LCD_HOST, &buscfg, SPI_DMA_CH_AUTO));            
 
@@ -27,7 +27,7 @@ void LCD_Init(void)
         .lcd_cmd_bits = EXAMPLE_LCD_CMD_BITS,
         .lcd_param_bits = EXAMPLE_LCD_PARAM_BITS,
         .spi_mode = 0,
-        .trans_queue_depth = 10,
+        .trans_queue_depth = CONFIG_LCD_TRANS_QUEUE_DEPTH,
         .on_color_trans_done = example_notify_lvgl_flush_ready,
         .user_ctx = &disp_drv,
     };
@@ -37,7 +37,7 @@ void LCD_Init(void)
     esp_lcd_panel_dev_st7789t_config_t panel_config = {
         .reset_gpio_num = EXAMPLE_PIN_NUM_LCD_RST,
         .rgb_endian = LCD_RGB_ENDIAN_BGR,
-        .bits_per_pixel = 16,
+        .bits_per_pixel = EXAMPLE_LCD_BITS_PER_PIXEL,
     };
     ESP_LOGI(TAG_LCD, "Install ST7789T panel driver");
     ESP_ERROR_CHECK(esp_lcd_new_panel_st7789t(io_handle, &panel_config, &panel_handle));
@@ -88,13 +88,24 @@ void BK_Init(void)
     ledc_channel_config(&ledc_channel);
     ledc_fade_func_install(0);
 }
+static uint16_t BK_Duty(uint8_t Light)
+{
+    if(Light > 100) Light = 100;
+    if(Light == 0) return 0;
+    return LEDC_MAX_Duty-(81*(100-Light));
+}
 void BK_Light(uint8_t Light)
 {   
-    if(Light > 100) Light = 100;
-    uint16_t Duty = LEDC_MAX_Duty-(81*(100-Light));
-    if(Light == 0) Duty = 0;
+    // a running fade would overwrite the new duty, stop it first
+    ledc_fade_stop(ledc_channel.speed_mode, ledc_channel.channel);
     // 设置PWM占空比
-    ledc_set_duty(ledc_channel.speed_mode, ledc_channel.channel, Duty);
+    ledc_set_duty(ledc_channel.speed_mode, ledc_channel.channel, BK_Duty(Light));
     ledc_update_duty(ledc_channel.speed_mode, ledc_channel.channel);
 }
+void BK_Fade(uint8_t Light, uint32_t Time_ms)
+{
+    ledc_fade_stop(ledc_channel.speed_mode, ledc_channel.channel);
+    ledc_set_fade_with_time(ledc_channel.speed_mode, ledc_channel.channel, BK_Duty(Light), Time_ms);
+    ledc_fade_start(ledc_channel.speed_mode, ledc_channel.channel, LEDC_FADE_NO_WAIT);
+}
 // end Backlight program
\ No newline at end of file
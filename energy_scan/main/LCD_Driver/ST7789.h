@@ -35,6 +35,12 @@
 // Bit number used to represent command and parameter
 #define EXAMPLE_LCD_CMD_BITS           8
 #define EXAMPLE_LCD_PARAM_BITS         8
+// Bits per pixel on the wire, LVGL always renders RGB565
+#if CONFIG_LCD_COLOR_12BIT
+#define EXAMPLE_LCD_BITS_PER_PIXEL     12
+#else
+#define EXAMPLE_LCD_BITS_PER_PIXEL     16
+#endif
 
 #define Offset_X 34
 #define Offset_Y 0
@@ -53,5 +59,6 @@ extern esp_lcd_panel_handle_t panel_handle;
 
 void BK_Init(void);                             // Initialize the LCD backlight, which has been called in the LCD_Init function, ignore it                                                         
 void BK_Light(uint8_t Light);                   // Call this function to adjust the brightness of the backlight. The value of the parameter Light ranges from 0 to 100
+void BK_Fade(uint8_t Light, uint32_t Time_ms); // Fade the backlight to Light (0 to 100) over Time_ms without blocking
 
 void LCD_Init(void);                     // Call this function to initialize the screen (must be called in the main function) !!!!!
\ No newline at end of file
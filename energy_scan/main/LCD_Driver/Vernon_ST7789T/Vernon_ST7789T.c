@@ -22,6 +22,9 @@
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_rom_sys.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 
 #include "Vernon_ST7789T/Vernon_ST7789T.h"
 
@@ -36,6 +39,7 @@ static esp_err_t panel_st7789t_mirror(esp_lcd_panel_t *panel, bool mirror_x, boo
 static esp_err_t panel_st7789t_swap_xy(esp_lcd_panel_t *panel, bool swap_axes);
 static esp_err_t panel_st7789t_set_gap(esp_lcd_panel_t *panel, int x_gap, int y_gap);
 static esp_err_t panel_st7789t_disp_on_off(esp_lcd_panel_t *panel, bool off);
+static esp_err_t panel_st7789t_disp_sleep(esp_lcd_panel_t *panel, bool sleep);
 
 typedef struct {
     esp_lcd_panel_t base;
@@ -47,6 +51,7 @@ typedef struct {
     uint8_t fb_bits_per_pixel;
     uint8_t madctl_val; // save current value of LCD_CMD_MADCTL register
     uint8_t colmod_cal; // save surrent value of LCD_CMD_COLMOD register
+    int64_t slpin_us;   // time of the last SLPIN, SLPOUT must not follow within 120 ms
 } st7789t_panel_t;
 
 esp_err_t esp_lcd_new_panel_st7789t(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_st7789t_config_t *panel_dev_config, esp_lcd_panel_handle_t *ret_panel)
@@ -82,6 +87,11 @@ esp_err_t esp_lcd_new_panel_st7789t(const esp_lcd_panel_io_handle_t io, const es
 
     uint8_t fb_bits_per_pixel = 0;
     switch (panel_dev_config->bits_per_pixel) {
+    case 12: // RGB444
+        st7789t->colmod_cal = 0x53;
+        // two pixels are packed into three bytes, the caller provides the packed buffer
+        fb_bits_per_pixel = 12;
+        break;
     case 16: // RGB565
         st7789t->colmod_cal = 0x55;
         fb_bits_per_pixel = 16;
@@ -109,6 +119,7 @@ esp_err_t esp_lcd_new_panel_st7789t(const esp_lcd_panel_io_handle_t io, const es
     st7789t->base.mirror = panel_st7789t_mirror;
     st7789t->base.swap_xy = panel_st7789t_swap_xy;
     st7789t->base.disp_on_off = panel_st7789t_disp_on_off;
+    st7789t->base.disp_sleep = panel_st7789t_disp_sleep;
     *ret_panel = &(st7789t->base);
     ESP_LOGD(TAG, "new st7789t panel @%p", st7789t);
     // printf("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\r\n");
@@ -136,6 +147,79 @@ static esp_err_t panel_st7789t_del(esp_lcd_panel_t *panel)
     return ESP_OK;
 }
 
+/*
+ * Delays below are the datasheet minimums. A hardware reset and SLPOUT both need 5 ms before the next
+ * command, but a reset that hits the panel while it is out of sleep (e.g. after a software restart of
+ * the ESP32) takes up to 120 ms to complete. SWRESET always needs 120 ms before SLPOUT.
+ */
+#define ST7789T_RESET_PULSE_US      10
+#define ST7789T_RESET_SETTLE_MS     5
+#define ST7789T_RESET_AWAKE_MS      120
+#define ST7789T_SWRESET_MS          120
+#define ST7789T_SLPOUT_MS           5
+#define ST7789T_SLPIN_MS            5
+#define ST7789T_SLPIN_TO_SLPOUT_MS  120
+
+static const st7789t_lcd_init_cmd_t st7789t_init_cmds[] = {
+    // LCD goes into sleep mode and display will be turned off after power on reset, exit sleep mode first
+    {LCD_CMD_SLPOUT, NULL, 0, ST7789T_SLPOUT_MS},
+    /* Memory Data Access Control, MX=MV=1, MY=ML=MH=0, RGB=0 */
+    {0x36, (uint8_t []){0x00}, 1, 0},
+    /* Interface Pixel Format is sent separately with the value chosen at panel creation */
+    {0xB0, (uint8_t []){0x00, 0xE8}, 2, 0},
+    /* Porch Setting */
+    {0xB2, (uint8_t []){0x0c, 0x0c, 0x00, 0x33, 0x33}, 5, 0},
+    /* Gate Control, Vgh=13.65V, Vgl=-10.43V */
+    {0xB7, (uint8_t []){0x75}, 1, 0},
+    /* VCOM Setting, VCOM=1.175V */
+    {0xBB, (uint8_t []){0x1A}, 1, 0},
+    /* LCM Control, XOR: BGR, MX, MH */
+    {0xC0, (uint8_t []){0x80}, 1, 0},
+    /* VDV and VRH Command Enable, enable=1 */
+    {0xC2, (uint8_t []){0x01, 0xff}, 2, 0},
+    /* VRH Set, Vap=4.4+... */
+    {0xC3, (uint8_t []){0x13}, 1, 0},
+    /* VDV Set, VDV=0 */
+    {0xC4, (uint8_t []){0x20}, 1, 0},
+    /* Frame Rate Control, 60Hz, inversion=0 */
+    {0xC6, (uint8_t []){0x0F}, 1, 0},
+    /* Power Control 1, AVDD=6.8V, AVCL=-4.8V, VDDS=2.3V */
+    {0xD0, (uint8_t []){0xA4, 0xA1}, 1, 0},
+    /* Positive Voltage Gamma Control */
+    {0xE0, (uint8_t []){0xD0, 0x0D, 0x14, 0x0D, 0x0D, 0x09, 0x38, 0x44, 0x4E, 0x3A, 0x17, 0x18, 0x2F, 0x30}, 14, 0},
+    /* Negative Voltage Gamma Control */
+    {0xE1, (uint8_t []){0xD0, 0x09, 0x0F, 0x08, 0x07, 0x14, 0x37, 0x44, 0x4D, 0x38, 0x15, 0x16, 0x2C, 0x2E}, 14, 0},
+    /* Display Inversion On */
+    {LCD_CMD_INVON, NULL, 0, 0},
+    /* Display On */
+    {LCD_CMD_DISPON, NULL, 0, 0},
+    {LCD_CMD_RAMWR, NULL, 0, 0},
+};
+
+static void st7789t_delay_ms(uint32_t ms)
+{
+    if (ms == 0) {
+        return;
+    }
+    if (ms < portTICK_PERIOD_MS) {
+        // shorter than one tick, vTaskDelay would round it down to nothing
+        esp_rom_delay_us(ms * 1000);
+    } else {
+        // vTaskDelay(n) may return up to one tick early, add one so the minimum always holds
+        vTaskDelay(pdMS_TO_TICKS(ms) + 1);
+    }
+}
+
+static esp_err_t panel_st7789t_run_cmds(esp_lcd_panel_io_handle_t io, const st7789t_lcd_init_cmd_t *cmds, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, cmds[i].cmd, cmds[i].data, cmds[i].data_bytes), TAG,
+                            "send command 0x%02x failed", cmds[i].cmd);
+        st7789t_delay_ms(cmds[i].delay_ms);
+    }
+    return ESP_OK;
+}
+
 static esp_err_t panel_st7789t_reset(esp_lcd_panel_t *panel)
 {
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
@@ -143,13 +227,15 @@ static esp_err_t panel_st7789t_reset(esp_lcd_panel_t *panel)
 
     // perform hardware reset
     if (st7789t->reset_gpio_num >= 0) {
+        // after a power-on reset the panel is still in sleep, any other reset may find it awake
+        uint32_t settle_ms = esp_reset_reason() == ESP_RST_POWERON ? ST7789T_RESET_SETTLE_MS : ST7789T_RESET_AWAKE_MS;
         gpio_set_level(st7789t->reset_gpio_num, st7789t->reset_level);
-        vTaskDelay(pdMS_TO_TICKS(10));
+        esp_rom_delay_us(ST7789T_RESET_PULSE_US);
         gpio_set_level(st7789t->reset_gpio_num, !st7789t->reset_level);
-        vTaskDelay(pdMS_TO_TICKS(10));
+        st7789t_delay_ms(settle_ms);
     } else { // perform software reset
         esp_lcd_panel_io_tx_param(io, LCD_CMD_SWRESET, NULL, 0);
-        vTaskDelay(pdMS_TO_TICKS(20)); // spec, wait at least 5m before sending new command
+        st7789t_delay_ms(ST7789T_SWRESET_MS);
     }
 
     return ESP_OK;
@@ -159,49 +245,13 @@ static esp_err_t panel_st7789t_init(esp_lcd_panel_t *panel)
 {
     st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
     esp_lcd_panel_io_handle_t io = st7789t->io;
-    // LCD goes into sleep mode and display will be turned off after power on reset, exit sleep mode first
-    // printf("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\r\n");
-    esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPOUT, NULL, 0);
-    vTaskDelay(pdMS_TO_TICKS(100));
-    // esp_lcd_panel_io_tx_param(io, LCD_CMD_MADCTL, (uint8_t[]) {st7789t->madctl_val,}, 1);
-    // esp_lcd_panel_io_tx_param(io, LCD_CMD_COLMOD, (uint8_t[]) {st7789t->colmod_cal,}, 1);
-    
-    /* Memory Data Access Control, MX=MV=1, MY=ML=MH=0, RGB=0 */
-    esp_lcd_panel_io_tx_param(io, 0x36, (uint8_t []){0x00}, 1);                           // 0x36: 接口像素格式 X镜像，Y镜像
-    /* Interface Pixel Format, 16bits/pixel for RGB/MCU interface */
-    esp_lcd_panel_io_tx_param(io, 0x3A, (uint8_t []){0x55}, 1);                           // 0x3A: Porch 设置
-    
-    esp_lcd_panel_io_tx_param(io, 0xB0, (uint8_t []){0x00, 0xE8}, 2);   
-    /* Porch Setting */
-    esp_lcd_panel_io_tx_param(io, 0xB2, (uint8_t []){0x0c, 0x0c, 0x00, 0x33, 0x33}, 5);      
-    /* Gate Control, Vgh=13.65V, Vgl=-10.43V */
-    esp_lcd_panel_io_tx_param(io, 0xB7, (uint8_t []){0x75}, 1);
-    /* VCOM Setting, VCOM=1.175V */
-    esp_lcd_panel_io_tx_param(io, 0xBB, (uint8_t []){0x1A}, 1);
-    /* LCM Control, XOR: BGR, MX, MH */
-    esp_lcd_panel_io_tx_param(io, 0xC0, (uint8_t []){0x80}, 1);
-    /* VDV and VRH Command Enable, enable=1 */
-    esp_lcd_panel_io_tx_param(io, 0xC2, (uint8_t []){0x01, 0xff}, 2);
-    /* VRH Set, Vap=4.4+... */
-    esp_lcd_panel_io_tx_param(io, 0xC3, (uint8_t []){0x13}, 1);
-    /* VDV Set, VDV=0 */
-    esp_lcd_panel_io_tx_param(io, 0xC4, (uint8_t []){0x20}, 1);
-    /* Frame Rate Control, 60Hz, inversion=0 */
-    esp_lcd_panel_io_tx_param(io, 0xC6, (uint8_t []){0x0F}, 1);
-    /* Power Control 1, AVDD=6.8V, AVCL=-4.8V, VDDS=2.3V */
-    esp_lcd_panel_io_tx_param(io, 0xD0, (uint8_t []){0xA4, 0xA1}, 1);
-    /* Positive Voltage Gamma Control */
-    esp_lcd_panel_io_tx_param(io, 0xE0, (uint8_t []){0xD0, 0x0D, 0x14, 0x0D, 0x0D, 0x09, 0x38, 0x44, 0x4E, 0x3A, 0x17, 0x18, 0x2F, 0x30}, 14);
-    /* Negative Voltage Gamma Control */
-    esp_lcd_panel_io_tx_param(io, 0xE1, (uint8_t []){0xD0, 0x09, 0x0F, 0x08, 0x07, 0x14, 0x37, 0x44, 0x4D, 0x38, 0x15, 0x16, 0x2C, 0x2E}, 14);
-    /* Sleep Out */
-    esp_lcd_panel_io_tx_param(io, 0x21, NULL, 0);
-    /* Display On */
-    esp_lcd_panel_io_tx_param(io, 0x29, NULL, 0);
-
-    esp_lcd_panel_io_tx_param(io, 0x2C, NULL, 0);
 
-    return ESP_OK;
+    // SLPOUT, then the pixel format chosen at creation, then the static panel setup
+    ESP_RETURN_ON_ERROR(panel_st7789t_run_cmds(io, st7789t_init_cmds, 1), TAG, "sleep out failed");
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_COLMOD, (uint8_t []) {
+        st7789t->colmod_cal
+    }, 1), TAG, "set pixel format failed");
+    return panel_st7789t_run_cmds(io, st7789t_init_cmds + 1, sizeof(st7789t_init_cmds) / sizeof(st7789t_init_cmds[0]) - 1);
 }
 
 static esp_err_t panel_st7789t_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data)
@@ -229,7 +279,8 @@ static esp_err_t panel_st7789t_draw_bitmap(esp_lcd_panel_t *panel, int x_start,
         (y_end - 1) & 0xFF,
     }, 4);
     // transfer frame buffer
-    size_t len = (x_end - x_start) * (y_end - y_start) * st7789t->fb_bits_per_pixel / 8;
+    // round up, an odd pixel count in 12-bit mode ends with a half-used byte
+    size_t len = ((x_end - x_start) * (y_end - y_start) * st7789t->fb_bits_per_pixel + 7) / 8;
     esp_lcd_panel_io_tx_color(io, LCD_CMD_RAMWR, color_data, len);
 
     return ESP_OK;
@@ -305,3 +356,22 @@ static esp_err_t panel_st7789t_disp_on_off(esp_lcd_panel_t *panel, bool on_off)
     esp_lcd_panel_io_tx_param(io, command, NULL, 0);
     return ESP_OK;
 }
+
+static esp_err_t panel_st7789t_disp_sleep(esp_lcd_panel_t *panel, bool sleep)
+{
+    st7789t_panel_t *st7789t = __containerof(panel, st7789t_panel_t, base);
+    esp_lcd_panel_io_handle_t io = st7789t->io;
+    if (sleep) {
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPIN, NULL, 0), TAG, "sleep in failed");
+        st7789t->slpin_us = esp_timer_get_time();
+        st7789t_delay_ms(ST7789T_SLPIN_MS);
+    } else {
+        int64_t since_us = esp_timer_get_time() - st7789t->slpin_us;
+        if (st7789t->slpin_us && since_us < ST7789T_SLPIN_TO_SLPOUT_MS * 1000) {
+            st7789t_delay_ms(ST7789T_SLPIN_TO_SLPOUT_MS - since_us / 1000);
+        }
+        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_SLPOUT, NULL, 0), TAG, "sleep out failed");
+        st7789t_delay_ms(ST7789T_SLPOUT_MS);
+    }
+    return ESP_OK;
+}
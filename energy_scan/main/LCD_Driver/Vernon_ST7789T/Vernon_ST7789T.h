@@ -6,6 +6,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
 #include "esp_lcd_types.h"
 
@@ -13,6 +14,16 @@
 extern "C" {
 #endif
 
+/**
+ * @brief One entry of the panel initialization sequence
+ */
+typedef struct {
+    int cmd;                /*!< The specific LCD command */
+    const void *data;       /*!< Buffer that holds the command specific data */
+    size_t data_bytes;      /*!< Size of `data` in memory, in bytes */
+    unsigned int delay_ms;  /*!< Minimum delay after this command, in milliseconds */
+} st7789t_lcd_init_cmd_t;
+
 /**
  * @brief Configuration structure for panel device
  */
@@ -22,7 +33,7 @@ typedef struct {
         lcd_color_rgb_endian_t color_space; /*!< @deprecated Set RGB color space, please use rgb_endian instead */
         lcd_color_rgb_endian_t rgb_endian;  /*!< Set RGB data endian: RGB or BGR */
     };
-    unsigned int bits_per_pixel;       /*!< Color depth, in bpp */
+    unsigned int bits_per_pixel;       /*!< Color depth, in bpp: 12 (packed RGB444), 16 (RGB565) or 18 (RGB666) */
     struct {
         unsigned int reset_active_high: 1; /*!< Setting this if the panel reset is high level active */
     } flags;                               /*!< LCD panel config flags */
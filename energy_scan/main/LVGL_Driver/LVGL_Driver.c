@@ -1,9 +1,14 @@
+#include <string.h>
 #include "LVGL_Driver.h"
+#include "rgb444.h"
 
 static const char *TAG_LVGL = "WS_LVGL";
 
-static lv_color_t buf1[ LVGL_BUF_LEN ];
-static lv_color_t buf2[ LVGL_BUF_LEN];
+// word aligned so the RGB444 packer can load two pixels at a time
+static lv_color_t buf1[ LVGL_BUF_LEN ] __attribute__((aligned(4)));
+#if CONFIG_LCD_DRAW_BUF_DOUBLE
+static lv_color_t buf2[ LVGL_BUF_LEN] __attribute__((aligned(4)));
+#endif
 // static lv_color_t* buf1 = (lv_color_t*) heap_caps_malloc(LVGL_BUF_LEN , MALLOC_CAP_SPIRAM);
 // static lv_color_t* buf2 = (lv_color_t*) heap_caps_malloc(LVGL_BUF_LEN , MALLOC_CAP_SPIRAM);
     
@@ -17,13 +22,47 @@ void example_increase_lvgl_tick(void *arg)
     lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
 }
 
+// Flush pipeline statistics, updated from the flush callback and the SPI done ISR
+static portMUX_TYPE flush_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static lvgl_flush_stats_t flush_stats;
+static int64_t flush_start_us;                                               // flush_cb entry of the flush on the wire
+static volatile int64_t flush_wait_start_us;                                 // first wait_cb call for that flush, 0 if LVGL never blocked
+static uint32_t flush_bytes;
+
 bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx)
 {
     lv_disp_drv_t *disp_driver = (lv_disp_drv_t *)user_ctx;
+#if CONFIG_LCD_FLUSH_STATS
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&flush_stats_lock);
+    flush_stats.flushes++;
+    flush_stats.bytes += flush_bytes;
+    flush_stats.wire_us += now - flush_start_us;
+    if (flush_wait_start_us) {
+        flush_stats.wait_us += now - flush_wait_start_us;
+        flush_wait_start_us = 0;
+    }
+    portEXIT_CRITICAL_ISR(&flush_stats_lock);
+#endif
     lv_disp_flush_ready(disp_driver);
     return false;
 }
 
+#if CONFIG_LCD_FLUSH_STATS
+/* Called by LVGL in a loop while it has no free draw buffer to render into */
+static void example_lvgl_wait_cb(lv_disp_drv_t *drv)
+{
+    if (!flush_wait_start_us) {
+        flush_wait_start_us = esp_timer_get_time();
+    }
+}
+#endif
+
+void example_rgb565_to_rgb444(const lv_color_t *src, uint8_t *dst, size_t pixels)
+{
+    rgb565_to_rgb444((const uint16_t *)src, dst, pixels, LV_COLOR_16_SWAP);
+}
+
 void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
 {
     esp_lcd_panel_handle_t panel_handle = (esp_lcd_panel_handle_t) drv->user_data;
@@ -31,10 +70,47 @@ void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t
     int offsetx2 = area->x2;
     int offsety1 = area->y1;
     int offsety2 = area->y2;
-    // copy a buffer's content to a specific area of the display
+#if CONFIG_LCD_FLUSH_STATS
+    flush_start_us = esp_timer_get_time();
+    flush_wait_start_us = 0;
+    flush_bytes = (lv_area_get_size(area) * EXAMPLE_LCD_BITS_PER_PIXEL + 7) / 8;
+#endif
+#if CONFIG_LCD_COLOR_12BIT
+    // pack in place, LVGL does not read the buffer back once it has been handed to flush_cb
+    example_rgb565_to_rgb444(color_map, (uint8_t *)color_map, lv_area_get_size(area));
+#endif
+    // copy a buffer's content to a specific area of the display.
+    // The panel IO splits the area into LVGL_DMA_CHUNK_BYTES transactions and queues them all,
+    // so this returns as soon as the chunks are queued and LVGL renders the next area while they
+    // are on the wire. Only the last chunk fires example_notify_lvgl_flush_ready.
     esp_lcd_panel_draw_bitmap(panel_handle, offsetx1 + Offset_X, offsety1 + Offset_Y, offsetx2 + Offset_X + 1, offsety2 + Offset_Y + 1, color_map);
 }
 
+void LVGL_Get_Flush_Stats(lvgl_flush_stats_t *stats, bool reset)
+{
+    portENTER_CRITICAL(&flush_stats_lock);
+    *stats = flush_stats;
+    if (reset) {
+        memset(&flush_stats, 0, sizeof(flush_stats));
+    }
+    portEXIT_CRITICAL(&flush_stats_lock);
+}
+
+void LVGL_Log_Flush_Stats(void)
+{
+    lvgl_flush_stats_t st;
+    LVGL_Get_Flush_Stats(&st, true);
+    if (st.flushes == 0 || st.wire_us == 0) {
+        return;
+    }
+    // bytes per microsecond is MB/s
+    uint32_t kbps = (uint32_t)(st.bytes * 1000 / st.wire_us);
+    uint32_t cpu_free = (uint32_t)(100 - (st.wait_us * 100 / st.wire_us));
+    ESP_LOGI(TAG_LVGL, "flush: %lu flushes, %lu.%03lu MB/s, CPU free while flushing %lu%%",
+             (unsigned long)st.flushes, (unsigned long)(kbps / 1000), (unsigned long)(kbps % 1000),
+             (unsigned long)cpu_free);
+}
+
 /* Rotate display and touch, when rotated screen in LVGL. Called when driver parameters are updated. */
 void example_lvgl_port_update_callback(lv_disp_drv_t *drv)
 {
@@ -71,7 +147,11 @@ void LVGL_Init(void)
     ESP_LOGI(TAG_LVGL, "Initialize LVGL library");
     lv_init();
     
+#if CONFIG_LCD_DRAW_BUF_DOUBLE
     lv_disp_draw_buf_init(&disp_buf, buf1, buf2, LVGL_BUF_LEN );                              // initialize LVGL draw buffers
+#else
+    lv_disp_draw_buf_init(&disp_buf, buf1, NULL, LVGL_BUF_LEN );                              // single buffer: render and flush are serialised
+#endif
 
     ESP_LOGI(TAG_LVGL, "Register display driver to LVGL");
     lv_disp_drv_init(&disp_drv);                                                                        // Create a new screen object and initialize the associated device
@@ -79,6 +159,9 @@ void LVGL_Init(void)
     disp_drv.ver_res = EXAMPLE_LCD_V_RES;                                                     // Horizontal pixel count
     // disp_drv.rotated = LV_DISP_ROT_90; // 图像旋转                                                            // Vertical axis pixel count
     disp_drv.flush_cb = example_lvgl_flush_cb;                                                          // Function : copy a buffer's content to a specific area of the display
+#if CONFIG_LCD_FLUSH_STATS
+    disp_drv.wait_cb = example_lvgl_wait_cb;                                                            // Function : called while LVGL waits for a free draw buffer
+#endif
     disp_drv.drv_update_cb = example_lvgl_port_update_callback;                                         // Function : Rotate display and touch, when rotated screen in LVGL. Called when driver parameters are updated. 
     disp_drv.draw_buf = &disp_buf;                                                                      // LVGL will use this buffer(s) to draw the screens contents
     disp_drv.user_data = panel_handle;                
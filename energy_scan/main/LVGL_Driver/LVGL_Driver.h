@@ -10,7 +10,8 @@
 
 #include "ST7789.h"
 
-#define LVGL_BUF_LEN  (EXAMPLE_LCD_H_RES * 20)
+#define LVGL_BUF_LEN  (EXAMPLE_LCD_H_RES * CONFIG_LCD_DRAW_BUF_LINES)
+#define LVGL_DMA_CHUNK_BYTES  (EXAMPLE_LCD_H_RES * CONFIG_LCD_DMA_CHUNK_LINES * sizeof(lv_color_t))
 #define EXAMPLE_LVGL_TICK_PERIOD_MS    2
 
 extern lv_disp_draw_buf_t disp_buf;                                                 // contains internal graphic buffer(s) called draw buffer(s)
@@ -19,8 +20,20 @@ extern lv_disp_t *disp;
 
 bool example_notify_lvgl_flush_ready(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_io_event_data_t *edata, void *user_ctx);
 void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+/* Pack RGB565 pixels into RGB444, two pixels per three bytes (COLMOD 0x53). dst may equal src. */
+void example_rgb565_to_rgb444(const lv_color_t *src, uint8_t *dst, size_t pixels);
 /* Rotate display and touch, when rotated screen in LVGL. Called when driver parameters are updated. */
 void example_lvgl_port_update_callback(lv_disp_drv_t *drv);
 void example_increase_lvgl_tick(void *arg);
 
+typedef struct {
+    uint32_t flushes;                   // completed flush_cb calls
+    uint64_t bytes;                     // pixel bytes sent to the panel
+    uint64_t wire_us;                   // time from flush_cb entry until the last chunk is done
+    uint64_t wait_us;                   // part of wire_us where LVGL was blocked waiting for the flush
+} lvgl_flush_stats_t;
+
+void LVGL_Get_Flush_Stats(lvgl_flush_stats_t *stats, bool reset);
+void LVGL_Log_Flush_Stats(void);         // Log CPU-free-while-flushing and MB/s since the last call
+
 void LVGL_Init(void);                     // Call this function to initialize the screen (must be called in the main function) !!!!!
\ No newline at end of file
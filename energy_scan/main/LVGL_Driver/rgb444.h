@@ -0,0 +1,44 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Pack RGB565 pixels into RGB444, two pixels per three bytes (COLMOD 0x53). dst may equal src.
+ * src must be 4-byte aligned. swap is LVGL's LV_COLOR_16_SWAP: the input pixels are big endian.
+ * Kept free of ESP-IDF and LVGL headers so it can be built and checked on a host.
+ */
+static inline void rgb565_to_rgb444(const uint16_t *src, uint8_t *dst, size_t pixels, bool swap)
+{
+    const uint32_t *in = (const uint32_t *)src;
+    size_t pairs = pixels / 2;
+
+    // Each 32-bit load holds two pixels, one per 16-bit lane, and all three channels of both
+    // lanes are reduced to 4 bits with one shift and mask. The output for pair i ends at byte 3i+2,
+    // which is always below the next load at byte 4(i+1), so converting in place is safe.
+    for (size_t i = 0; i < pairs; i++) {
+        uint32_t w = in[i];
+        if (swap) {
+            w = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+        }
+        uint32_t r = (w >> 12) & 0x000F000F;
+        uint32_t g = (w >> 7) & 0x000F000F;
+        uint32_t b = (w >> 1) & 0x000F000F;
+        uint32_t v = (r << 8) | (g << 4) | b;   // 0x0RGB0RGB, first pixel in the low lane
+        uint32_t p0 = v & 0xFFF;
+        uint32_t p1 = v >> 16;
+        dst[0] = p0 >> 4;
+        dst[1] = (p0 << 4) | (p1 >> 8);
+        dst[2] = p1;
+        dst += 3;
+    }
+    if (pixels & 1) {
+        uint32_t w = src[pixels - 1];
+        if (swap) {
+            w = ((w & 0xFF) << 8) | (w >> 8);
+        }
+        uint32_t v = ((w >> 4) & 0xF00) | ((w >> 3) & 0x0F0) | ((w >> 1) & 0x00F);
+        dst[0] = v >> 4;
+        dst[1] = v << 4;
+    }
+}
@@ -5,6 +5,14 @@
 
 #define BLINK_GPIO 8
 
+#define RGB_STATUS_LEVELS   8      // occupancy levels shown, the LED is only written when the level changes
+#define RGB_STATUS_MAX      48     // brightest channel value used for the occupancy colour
+#define RGB_FLASH_VAL       160    // white flash on a trigger event
+#define RGB_FLASH_MS        100
+
 void RGB_Init(void);
 void Set_RGB( uint8_t red_val, uint8_t green_val, uint8_t blue_val);
-void RGB_Example(void);
\ No newline at end of file
+void RGB_Status_Init(void);                           // Call after RGB_Init
+void RGB_Status_Occupancy(uint8_t busy_percent);       // Show the occupancy (busy samples, %) of the busiest channel
+void RGB_Status_Trigger(void);                         // Flash the LED, a flash in progress is extended
+void RGB_Log_Stats(void);                              // Log LED writes and time spent since the last call
\ No newline at end of file
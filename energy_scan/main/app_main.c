@@ -8,6 +8,7 @@
 #include "esp_lvgl_port.h"
 #include "driver/gpio.h"
 #include "freertos/semphr.h"
+#include "boot_trace.h"
 
 #define BOOT_BUTTON_GPIO 9
 
@@ -38,6 +39,7 @@ static void IRAM_ATTR button_isr_handler(void* arg)
 
 void app_main(void)
 {
+    boot_trace_mark("app_main");
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
         ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -45,6 +47,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_trace_mark("nvs");
 
     // Create the semaphore
     button_sem = xSemaphoreCreateBinary();
@@ -60,24 +63,30 @@ void app_main(void)
     // Install ISR service and add handler
     gpio_install_isr_service(0);
     gpio_isr_handler_add(BOOT_BUTTON_GPIO, button_isr_handler, NULL);
+    boot_trace_mark("button");
 
 
     RGB_Init();
-    RGB_Example();
+    RGB_Status_Init();
+    boot_trace_mark("rgb");
 
     LCD_Init();
     BK_Light(50);
+    boot_trace_mark("lcd");
     LVGL_Init();
+    boot_trace_mark("lvgl");
 
     const lvgl_port_cfg_t lvgl_cfg = ESP_LVGL_PORT_INIT_CONFIG();
     esp_err_t err = lvgl_port_init(&lvgl_cfg);
     assert(err == ESP_OK);
+    boot_trace_mark("lvgl_port");
 
 //    Lvgl_Example1();
 //    lv_disp_t *disp = lv_disp_get_default();
 //    lv_disp_set_rotation(disp, LV_DISP_ROT_90);
 
     ieee_scan_start();
+    boot_trace_mark("scan_start");
     xTaskCreate(ui_task, "ui", 4096, NULL, 4, NULL);
     xTaskCreate(button_task, "button_task", 2048, NULL, 10, NULL);
 
@@ -0,0 +1,34 @@
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "boot_trace.h"
+
+#define TAG          "BOOT"
+#define MAX_PHASES   16
+
+typedef struct { const char *phase; int64_t us; } boot_mark_t;
+
+static boot_mark_t s_marks[MAX_PHASES];
+static int s_mark_cnt;
+static bool s_dumped;
+
+void boot_trace_mark(const char *phase)
+{
+    if (s_mark_cnt < MAX_PHASES) {
+        s_marks[s_mark_cnt].phase = phase;
+        s_marks[s_mark_cnt].us = esp_timer_get_time();
+        s_mark_cnt++;
+    }
+}
+
+void boot_trace_dump(void)
+{
+    if (s_dumped) return;
+    s_dumped = true;
+
+    int64_t prev = 0;
+    for (int i = 0; i < s_mark_cnt; i++) {
+        ESP_LOGI(TAG, "%-24s at %6lld us  (+%lld us)", s_marks[i].phase,
+                 s_marks[i].us, s_marks[i].us - prev);
+        prev = s_marks[i].us;
+    }
+}
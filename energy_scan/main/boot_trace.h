@@ -0,0 +1,8 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Record the time of a named boot phase. The name must be a string literal. */
+extern void boot_trace_mark(const char *phase);
+/* Log every recorded phase with its time since boot and since the previous phase. Runs once. */
+extern void boot_trace_dump(void);
@@ -0,0 +1,119 @@
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_lcd_panel_ops.h"
+#include "ST7789.h"
+#include "display_pm.h"
+
+#define TAG          "DISPPM"
+
+#define DIM_FADE_MS  1000
+
+static const char *s_state_name[DISPLAY_PM_STATE_CNT] = { "active", "idle", "dim", "sleep" };
+
+static display_pm_state_t s_state = DISPLAY_PM_ACTIVE;
+static uint8_t  s_brightness;
+static int64_t  s_last_change_us;       // last frame that changed beyond the threshold
+static int64_t  s_last_wake_us;         // last button press or trigger event
+static int64_t  s_state_since_us;
+static int64_t  s_state_us[DISPLAY_PM_STATE_CNT];
+
+static void set_state(display_pm_state_t state)
+{
+    if (state == s_state) return;
+
+    int64_t now = esp_timer_get_time();
+    s_state_us[s_state] += now - s_state_since_us;
+    s_state_since_us = now;
+
+    if (s_state == DISPLAY_PM_SLEEP) {
+        esp_lcd_panel_disp_sleep(panel_handle, false);
+        esp_lcd_panel_disp_on_off(panel_handle, true);
+    }
+    switch (state) {
+    case DISPLAY_PM_ACTIVE:
+    case DISPLAY_PM_IDLE:
+        BK_Light(s_brightness);
+        break;
+    case DISPLAY_PM_DIM:
+        BK_Fade(CONFIG_DISPLAY_PM_DIM_PERCENT, DIM_FADE_MS);
+        break;
+    case DISPLAY_PM_SLEEP:
+        BK_Light(0);
+        esp_lcd_panel_disp_on_off(panel_handle, false);
+        esp_lcd_panel_disp_sleep(panel_handle, true);
+        break;
+    default:
+        break;
+    }
+    ESP_LOGI(TAG, "%s -> %s", s_state_name[s_state], s_state_name[state]);
+    s_state = state;
+}
+
+void display_pm_init(uint8_t brightness)
+{
+    s_brightness = brightness;
+    s_last_change_us = s_last_wake_us = s_state_since_us = esp_timer_get_time();
+    s_state = DISPLAY_PM_ACTIVE;
+    BK_Light(s_brightness);
+}
+
+void display_pm_frame_change(int change_db)
+{
+    if (change_db < CONFIG_DISPLAY_PM_CHANGE_DB) return;
+    s_last_change_us = esp_timer_get_time();
+    // a changing spectrum restores the frame rate but does not wake a dimmed or sleeping panel
+    if (s_state == DISPLAY_PM_IDLE) {
+        set_state(DISPLAY_PM_ACTIVE);
+    }
+}
+
+bool display_pm_wake(void)
+{
+    bool was_asleep = s_state == DISPLAY_PM_SLEEP;
+    s_last_change_us = s_last_wake_us = esp_timer_get_time();
+    set_state(DISPLAY_PM_ACTIVE);
+    return was_asleep;
+}
+
+void display_pm_update(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t static_ms = (now - s_last_change_us) / 1000;
+    int64_t unattended_ms = (now - s_last_wake_us) / 1000;
+
+    // states only move towards SLEEP here, waking is done by display_pm_wake/frame_change
+    if (unattended_ms >= CONFIG_DISPLAY_PM_SLEEP_S * 1000LL) {
+        set_state(DISPLAY_PM_SLEEP);
+    } else if (unattended_ms >= CONFIG_DISPLAY_PM_DIM_S * 1000LL) {
+        if (s_state < DISPLAY_PM_DIM) set_state(DISPLAY_PM_DIM);
+    } else if (static_ms >= CONFIG_DISPLAY_PM_IDLE_S * 1000LL) {
+        if (s_state < DISPLAY_PM_IDLE) set_state(DISPLAY_PM_IDLE);
+    }
+}
+
+uint32_t display_pm_frame_period_ms(void)
+{
+    return s_state == DISPLAY_PM_ACTIVE ? 0 : CONFIG_DISPLAY_PM_IDLE_PERIOD_MS;
+}
+
+display_pm_state_t display_pm_get_state(void)
+{
+    return s_state;
+}
+
+void display_pm_log_stats(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t total = 0;
+    int64_t us[DISPLAY_PM_STATE_CNT];
+
+    for (int i = 0; i < DISPLAY_PM_STATE_CNT; i++) {
+        us[i] = s_state_us[i] + (i == s_state ? now - s_state_since_us : 0);
+        total += us[i];
+    }
+    if (total == 0) return;
+    ESP_LOGI(TAG, "active %lld s (%lld%%), idle %lld s (%lld%%), dim %lld s (%lld%%), sleep %lld s (%lld%%)",
+             us[0] / 1000000, us[0] * 100 / total, us[1] / 1000000, us[1] * 100 / total,
+             us[2] / 1000000, us[2] * 100 / total, us[3] / 1000000, us[3] * 100 / total);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    DISPLAY_PM_ACTIVE,          // full refresh rate, full brightness
+    DISPLAY_PM_IDLE,            // content static, refresh rate lowered
+    DISPLAY_PM_DIM,             // backlight faded down
+    DISPLAY_PM_SLEEP,           // backlight off, panel in DISPOFF + SLPIN
+    DISPLAY_PM_STATE_CNT
+} display_pm_state_t;
+
+/* Start in ACTIVE with the given backlight level (0-100). LCD_Init must have run. */
+extern void display_pm_init(uint8_t brightness);
+/* Report the largest per-channel change (dB) since the previous frame. */
+extern void display_pm_frame_change(int change_db);
+/* Button press or trigger event: back to ACTIVE at once. Returns true if the panel was asleep. */
+extern bool display_pm_wake(void);
+/* Run the timeouts: IDLE after the spectrum has been static, DIM and SLEEP after no button
+ * press or trigger for a while. Call from the UI task, it owns the panel. */
+extern void display_pm_update(void);
+/* Minimum time between canvas redraws in the current state, 0 means redraw at once. */
+extern uint32_t display_pm_frame_period_ms(void);
+extern display_pm_state_t display_pm_get_state(void);
+/* Log the time spent in each state since boot. */
+extern void display_pm_log_stats(void);
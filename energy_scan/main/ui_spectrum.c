@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "lvgl.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
@@ -5,6 +6,10 @@
 #include "ieee_scan.h"
 #include "esp_lvgl_port.h"
 #include "esp_log.h"
+#include "LVGL_Driver.h"
+#include "boot_trace.h"
+#include "display_pm.h"
+#include "RGB.h"
 
 #define TAG          "UI"
 
@@ -13,6 +18,9 @@
 #define CH_CNT     16
 #define COL_W      (CANVAS_W / CH_CNT)   // 20 px per channel slice
 #define SLICE_W  (CANVAS_W / CH_CNT)  // ≈10 px per channel
+#define STATS_PERIOD_MS  5000
+#define OCC_WINDOW       32    // ED samples per channel over which occupancy is computed, one bit each
+#define UI_BRIGHTNESS    50   // backlight level while the display is active
 
 // --- UI objects ---
 static lv_obj_t     *canvas;
@@ -132,17 +140,71 @@ static void clear_slice(int idx)
     lv_canvas_draw_rect(canvas, y, x, CANVAS_H, COL_W, &dsc);
 }
 
+/* Points received but not yet drawn, flushed at the rate the display power state allows */
+static int8_t   pending_pwr[CH_CNT];
+static uint32_t pending_mask;
+static int8_t   pending_chart[32];
+static int      pending_chart_cnt;
+static int8_t   last_pwr[CH_CNT];
+
+/* Busy/idle history of the last OCC_WINDOW samples per channel, newest in bit 0 */
+static uint32_t occ_hist[CH_CNT];
+static uint8_t  occ_cnt[CH_CNT];
+
+static void occ_add(int idx, int8_t pwr)
+{
+    occ_hist[idx] = (occ_hist[idx] << 1) | (pwr >= CONFIG_ED_BUSY_DBM);
+    if (occ_cnt[idx] < OCC_WINDOW) occ_cnt[idx]++;
+}
+
+// percentage of the samples in the window that were at or above the CCA threshold
+static uint8_t occ_percent(int idx)
+{
+    if (occ_cnt[idx] == 0) return 0;
+    return __builtin_popcount(occ_hist[idx]) * 100 / occ_cnt[idx];
+}
+
+static void flush_pending(uint32_t *drawn_mask)
+{
+    for (int idx = 0; idx < CH_CNT; idx++) {
+        if (pending_mask & (1u << idx)) {
+            clear_slice(idx);
+            draw_channel(idx + CH_FIRST, pending_pwr[idx]);
+        }
+    }
+    *drawn_mask |= pending_mask;
+    pending_mask = 0;
+
+    for (int i = 0; i < pending_chart_cnt && chart_series; i++) {
+        lv_chart_set_next_value(chart, chart_series, pending_chart[i]);
+    }
+    pending_chart_cnt = 0;
+}
+
 void ui_task(void *arg)
 {
     button_sem = xSemaphoreCreateBinary();
     ui_spectrum_create();
     ieee_scan_set_mode(SCAN_MODE_SWEEP, 0);
+    display_pm_init(UI_BRIGHTNESS);
+    boot_trace_mark("ui_created");
 
     QueueHandle_t q = ieee_scan_get_queue();
     ed_point_t pt;
+    TickType_t stats_tick = xTaskGetTickCount();
+    TickType_t draw_tick = 0;
+    uint32_t first_frame_mask = 0;   // channels drawn so far, until the first full spectrum is on screen
+    bool first_frame_seen = false;
+
+    for (int idx = 0; idx < CH_CNT; idx++) {
+        last_pwr[idx] = -100;
+    }
 
     for (;;) {
-        if (xSemaphoreTake(button_sem, 0) == pdTRUE) {
+        // the first press only wakes a sleeping panel, it does not change the mode
+        if (xSemaphoreTake(button_sem, 0) == pdTRUE && !display_pm_wake()) {
+            pending_mask = 0;
+            pending_chart_cnt = 0;
             if (ui_mode == SCAN_MODE_SWEEP) {
                 ui_mode = SCAN_MODE_SINGLE_CHANNEL;
                 clear_screen();
@@ -172,22 +234,69 @@ void ui_task(void *arg)
         }
 
         /* Loop here to ensure to get some of the queue reviced quickly */
+        int max_change = 0;
         for (int i = 0; i < 10 && xQueueReceive(q, &pt, 0) == pdTRUE; i++) {
+            int idx = pt.ch - CH_FIRST;
+            if (idx < 0 || idx >= CH_CNT) continue;
+
+            int change = abs(pt.pwr - last_pwr[idx]);
+            if (change > max_change) max_change = change;
+            last_pwr[idx] = pt.pwr;
+            occ_add(idx, pt.pwr);
+            if (pt.pwr >= CONFIG_ED_TRIGGER_DBM) {
+                display_pm_wake();
+                RGB_Status_Trigger();
+            }
+
             if (ui_mode == SCAN_MODE_SWEEP) {
-                int idx = pt.ch - 11;
-                if (idx >= 0 && idx < CH_CNT) {
-                    clear_slice(idx);
-                    draw_channel(pt.ch, pt.pwr);
-                }
+                pending_pwr[idx] = pt.pwr;
+                pending_mask |= 1u << idx;
             } else { // Single channel mode
-                if (chart_series) {
-                    lv_chart_set_next_value(chart, chart_series, pt.pwr);
+                if (pending_chart_cnt == sizeof(pending_chart)) {
+                    flush_pending(&first_frame_mask);
                 }
+                pending_chart[pending_chart_cnt++] = pt.pwr;
             }
         }
         ESP_LOGI(TAG, "Scan mode: %d, channel: %d, power: %d", ui_mode, pt.ch, pt.pwr);
+
+        // the status LED shows the busiest channel, it is only written when the level changes
+        uint8_t busiest = 0;
+        if (ui_mode == SCAN_MODE_SWEEP) {
+            for (int idx = 0; idx < CH_CNT; idx++) {
+                uint8_t occ = occ_percent(idx);
+                if (occ > busiest) busiest = occ;
+            }
+        } else {
+            busiest = occ_percent(s_single_channel - CH_FIRST);
+        }
+        RGB_Status_Occupancy(busiest);
+
+        display_pm_frame_change(max_change);
+        display_pm_update();
+        // nothing is drawn while the panel sleeps, the latest values are drawn on wake-up
+        if (display_pm_get_state() != DISPLAY_PM_SLEEP &&
+            xTaskGetTickCount() - draw_tick >= pdMS_TO_TICKS(display_pm_frame_period_ms())) {
+            draw_tick = xTaskGetTickCount();
+            flush_pending(&first_frame_mask);
+        }
  
         lv_timer_handler();
+
+        if (!first_frame_seen && first_frame_mask == (1u << CH_CNT) - 1) {
+            first_frame_seen = true;
+            boot_trace_mark("first_spectrum_frame");
+            boot_trace_dump();
+        }
+
+        if (xTaskGetTickCount() - stats_tick >= pdMS_TO_TICKS(STATS_PERIOD_MS)) {
+            stats_tick = xTaskGetTickCount();
+#if CONFIG_LCD_FLUSH_STATS
+            LVGL_Log_Flush_Stats();
+#endif
+            display_pm_log_stats();
+            RGB_Log_Stats();
+        }
         vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
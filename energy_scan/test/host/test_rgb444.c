@@ -0,0 +1,132 @@
+/*
+ * Host test for the RGB565 -> RGB444 packer used by the 12-bit flush path.
+ *
+ * Checks every pixel count from 0 to 64 (odd counts take the tail path), both
+ * LV_COLOR_16_SWAP settings and in-place conversion against a per-pixel
+ * reference, then reports the throughput of both on a full 320x172 frame.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rgb444.h"
+
+#define FRAME_PIXELS  (320 * 172)
+#define BENCH_ROUNDS  200
+
+static int failures;
+
+/* One pixel at a time, written the obvious way */
+static void ref_rgb565_to_rgb444(const uint16_t *src, uint8_t *dst, size_t pixels, bool swap)
+{
+    for (size_t i = 0; i < pixels; i++) {
+        uint16_t p = src[i];
+        if (swap) {
+            p = (uint16_t)((p << 8) | (p >> 8));
+        }
+        uint8_t r = (p >> 11) >> 1;            // 5 -> 4 bits
+        uint8_t g = ((p >> 5) & 0x3F) >> 2;    // 6 -> 4 bits
+        uint8_t b = (p & 0x1F) >> 1;           // 5 -> 4 bits
+        uint16_t v = (r << 8) | (g << 4) | b;
+        size_t bit = i * 12;
+        if (bit % 8 == 0) {
+            dst[bit / 8] = v >> 4;
+            dst[bit / 8 + 1] = (v << 4) & 0xF0;
+        } else {
+            dst[bit / 8] |= v >> 8;
+            dst[bit / 8 + 1] = v;
+        }
+    }
+}
+
+static size_t packed_len(size_t pixels)
+{
+    return (pixels * 12 + 7) / 8;
+}
+
+static void check(const uint16_t *src, size_t pixels, bool swap)
+{
+    static uint8_t want[FRAME_PIXELS * 2];
+    static uint8_t got[FRAME_PIXELS * 2];
+    static uint16_t inplace[FRAME_PIXELS] __attribute__((aligned(4)));
+    size_t len = packed_len(pixels);
+
+    memset(want, 0, sizeof(want));
+    memset(got, 0xAA, sizeof(got));
+    ref_rgb565_to_rgb444(src, want, pixels, swap);
+
+    rgb565_to_rgb444(src, got, pixels, swap);
+    if (memcmp(want, got, len) != 0) {
+        printf("FAIL: %zu pixels, swap=%d\n", pixels, swap);
+        failures++;
+    }
+    if (got[len] != 0xAA) {
+        printf("FAIL: %zu pixels, swap=%d wrote past the packed length\n", pixels, swap);
+        failures++;
+    }
+
+    memcpy(inplace, src, pixels * sizeof(uint16_t));
+    rgb565_to_rgb444(inplace, (uint8_t *)inplace, pixels, swap);
+    if (memcmp(want, inplace, len) != 0) {
+        printf("FAIL: %zu pixels, swap=%d, in place\n", pixels, swap);
+        failures++;
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(const uint16_t *src, bool swap)
+{
+    static uint8_t dst[FRAME_PIXELS * 2];
+    double t0 = now_s();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        rgb565_to_rgb444(src, dst, FRAME_PIXELS, swap);
+        __asm__ volatile("" : : "r"(dst) : "memory");
+    }
+    double t1 = now_s();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        ref_rgb565_to_rgb444(src, dst, FRAME_PIXELS, swap);
+        __asm__ volatile("" : : "r"(dst) : "memory");
+    }
+    double t2 = now_s();
+    double mpix = (double)FRAME_PIXELS * BENCH_ROUNDS / 1e6;
+    printf("swap=%d: packer %.1f Mpixel/s, per-pixel reference %.1f Mpixel/s\n",
+           swap, mpix / (t1 - t0), mpix / (t2 - t1));
+}
+
+int main(void)
+{
+    static uint16_t src[FRAME_PIXELS] __attribute__((aligned(4)));
+
+    srand(1);
+    for (size_t i = 0; i < FRAME_PIXELS; i++) {
+        src[i] = (uint16_t)rand();
+    }
+    // the corner values first, so small counts cover them
+    src[0] = 0x0000;
+    src[1] = 0xFFFF;
+    src[2] = 0xF800;
+    src[3] = 0x07E0;
+    src[4] = 0x001F;
+
+    for (int swap = 0; swap <= 1; swap++) {
+        for (size_t n = 0; n <= 64; n++) {
+            check(src, n, swap);
+        }
+        check(src, FRAME_PIXELS - 1, swap);
+        check(src, FRAME_PIXELS, swap);
+    }
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("conversion OK\n");
+    bench(src, false);
+    bench(src, true);
+    return 0;
+}
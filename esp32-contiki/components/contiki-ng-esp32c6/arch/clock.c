@@ -1,5 +1,6 @@
 #include "contiki.h"
 #include "esp_timer.h"
+#include "contiki-task.h"
 
 static uint64_t boot_us;
 
@@ -21,4 +22,9 @@ unsigned long clock_seconds(void)
 void clock_delay_usec(uint16_t dt) {         /* busy-wait */
   uint64_t target = esp_timer_get_time() + dt;
   while(esp_timer_get_time() < target) ;
-}
\ No newline at end of file
+}
+
+uint64_t clock_arch_time_to_us(clock_time_t t)
+{
+  return boot_us + (uint64_t)t * 1000;
+}
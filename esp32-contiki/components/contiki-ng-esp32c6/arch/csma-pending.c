@@ -0,0 +1,115 @@
+/* csma-pending.c - CSMA that tells the radio when a neighbour's queue empties */
+#include "contiki.h"
+#include "net/mac/mac.h"
+#include "net/mac/csma/csma.h"
+#include "net/packetbuf.h"
+#include "net/queuebuf.h"
+#include "net/linkaddr.h"
+#include "radio-esp32c6.h"
+#include "csma-pending.h"
+#include <stdbool.h>
+
+/* CSMA holds at most this many frames */
+#define TX_REFS QUEUEBUF_NUM
+
+typedef struct {
+  mac_callback_t sent;
+  void *ptr;
+  linkaddr_t dest;
+  bool used;
+} tx_ref_t;
+
+static tx_ref_t refs[TX_REFS];
+/*---------------------------------------------------------------------------*/
+static tx_ref_t *
+ref_alloc(void)
+{
+  for(int i = 0; i < TX_REFS; i++) {
+    if(!refs[i].used) {
+      refs[i].used = true;
+      return &refs[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+dest_queued(const linkaddr_t *dest)
+{
+  for(int i = 0; i < TX_REFS; i++) {
+    if(refs[i].used && linkaddr_cmp(&refs[i].dest, dest)) {
+      return true;
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+/* CSMA is done with the frame: delivered, or dropped after its retries */
+static void
+packet_sent(void *ptr, int status, int transmissions)
+{
+  tx_ref_t *r = ptr;
+  mac_callback_t sent = r->sent;
+  void *sent_ptr = r->ptr;
+
+  r->used = false;
+  if(!dest_queued(&r->dest)) {
+    esp32c6_radio_pending_done(r->dest.u8, LINKADDR_SIZE == 2);
+  }
+  mac_call_sent_callback(sent, sent_ptr, status, transmissions);
+}
+/*---------------------------------------------------------------------------*/
+static void
+send(mac_callback_t sent, void *ptr)
+{
+  const linkaddr_t *dest = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  tx_ref_t *r = NULL;
+
+  if(!linkaddr_cmp(dest, &linkaddr_null)) {
+    r = ref_alloc();
+  }
+  if(r == NULL) {
+    /* broadcast, or more frames than CSMA can hold: it refuses those */
+    csma_driver.send(sent, ptr);
+    return;
+  }
+  r->sent = sent;
+  r->ptr = ptr;
+  linkaddr_copy(&r->dest, dest);
+  csma_driver.send(packet_sent, r);
+}
+/*---------------------------------------------------------------------------*/
+static void
+init(void)
+{
+  csma_driver.init();
+}
+/*---------------------------------------------------------------------------*/
+static void
+input(void)
+{
+  csma_driver.input();
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  return csma_driver.on();
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  return csma_driver.off();
+}
+/*---------------------------------------------------------------------------*/
+static int
+max_payload(void)
+{
+  return csma_driver.max_payload();
+}
+/*---------------------------------------------------------------------------*/
+
+const struct mac_driver esp32c6_csma_driver = {
+  "CSMA+pending", init, send, input, on, off, max_payload
+};
@@ -0,0 +1,18 @@
+/* csma-pending.h - CSMA that tells the radio when a neighbour's queue empties
+ *
+ * esp32c6_csma_driver wraps csma_driver. In coordinator mode the radio keeps
+ * the frame-pending bit set for a child that did not ACK, so that the child
+ * stays awake for CSMA's retry after its next data request. Once CSMA has no
+ * frame left for the child, sent or dropped after its retries, the bit would
+ * only keep the child awake for nothing: the wrapper counts the unicasts CSMA
+ * holds per neighbour and calls esp32c6_radio_pending_done() when the last
+ * one is freed.
+ */
+#ifndef CSMA_PENDING_H_
+#define CSMA_PENDING_H_
+
+#include "net/mac/mac.h"
+
+extern const struct mac_driver esp32c6_csma_driver;
+
+#endif /* CSMA_PENDING_H_ */
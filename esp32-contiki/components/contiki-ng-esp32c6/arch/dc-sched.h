@@ -0,0 +1,109 @@
+/* dc-sched.h - wake-up schedule arithmetic for radio duty cycling
+ *
+ * A duty-cycled receiver wakes every 'period' us at a fixed 'phase' within
+ * the period. A sender that knows the phase starts sending just before the
+ * receiver wakes instead of repeating the frame for a whole period.
+ *
+ * A channel check that finds activity keeps the radio on for a listen
+ * window instead, which activity extends, and the periodic wake-ups resume
+ * once it has passed.
+ *
+ * These are pure functions of time, period and phase with no ESP-IDF or
+ * Contiki dependency, so the schedule can be driven from a simulated clock
+ * on a host (test/test-dc-sched.c). Times are in us, which is also the
+ * rtimer tick here.
+ */
+#ifndef DC_SCHED_H_
+#define DC_SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+  uint32_t period;
+  uint32_t phase;                    /* this node's wake-up, < period */
+  uint32_t listen;                   /* radio kept on this long after activity */
+  bool listening;
+  uint64_t listen_until;
+} dc_sched_t;
+
+/*---------------------------------------------------------------------------*/
+/* Phase of time t within the period                                         */
+static inline uint32_t
+dc_phase_of(uint64_t t, uint32_t period)
+{
+  return (uint32_t)(t % period);
+}
+/*---------------------------------------------------------------------------*/
+/* First wake-up strictly after now, phase < period                          */
+static inline uint64_t
+dc_next_wake(uint64_t now, uint32_t period, uint32_t phase)
+{
+  uint64_t t = now - (now % period) + phase;
+  if(t <= now) {
+    t += period;
+  }
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+/* When a sender should start sending to reach a receiver with this phase:
+   'guard' us before its next wake-up, and never in the past.                */
+static inline uint64_t
+dc_strobe_start(uint64_t now, uint32_t period, uint32_t phase, uint32_t guard)
+{
+  return dc_next_wake(now + guard, period, phase) - guard;
+}
+/*---------------------------------------------------------------------------*/
+/* How long a sender repeats a frame that takes 'repeat' us to send and to
+   wait for its ACK. With the receiver's phase known it covers the guard on
+   both sides of the wake-up and the receiver's CCAs, otherwise (broadcast,
+   or phase unknown) a whole period plus the CCAs so that every receiver
+   wakes up during it. Plus one repetition: a receiver only takes a frame
+   that starts after it woke up.                                             */
+static inline uint32_t
+dc_strobe_len(uint32_t period, uint32_t guard, uint32_t cca_window, uint32_t repeat,
+              bool phase_known)
+{
+  return (phase_known ? 2 * guard : period) + cca_window + repeat;
+}
+/*---------------------------------------------------------------------------*/
+/* Receiver phase learnt from the SFD time of an acknowledged frame. The
+   receiver woke up less than one repetition before it, or it would have
+   taken the frame before, so the middle of that and half a guard earlier
+   is taken.                                                                 */
+static inline uint32_t
+dc_phase_from_ack(uint64_t tx_time, uint32_t period, uint32_t guard, uint32_t repeat)
+{
+  return dc_phase_of(tx_time + period - repeat / 2 - guard / 2, period);
+}
+/*---------------------------------------------------------------------------*/
+/* After a periodic channel check at 'now': the next wake-up. A busy
+   channel starts a listen window, checked again every quarter window.       */
+static inline uint64_t
+dc_after_check(dc_sched_t *s, uint64_t now, bool busy)
+{
+  if(busy) {
+    s->listening = true;
+    s->listen_until = now + s->listen;
+    return now + s->listen / 4;
+  }
+  return dc_next_wake(now, s->period, s->phase);
+}
+/*---------------------------------------------------------------------------*/
+/* During a listen window: activity extends it. Once it has passed,
+   listening is cleared and the periodic schedule resumes.                   */
+static inline uint64_t
+dc_after_listen(dc_sched_t *s, uint64_t now, bool activity)
+{
+  if(activity) {
+    s->listen_until = now + s->listen;
+  }
+  if(now < s->listen_until) {
+    return now + s->listen / 4;
+  }
+  s->listening = false;
+  return dc_next_wake(now, s->period, s->phase);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif /* DC_SCHED_H_ */
@@ -0,0 +1,120 @@
+/* ev-queue.h - lock-free multi-producer/single-consumer queue of events
+ *
+ * Any number of producers (ISRs, other FreeRTOS tasks, rtimer callbacks)
+ * push entries concurrently. A single consumer pops them. Each cell carries
+ * a sequence number: a producer claims a cell by advancing head with a
+ * compare-and-swap and publishes it by bumping the cell's sequence. The
+ * consumer only takes cells whose sequence says they are complete. So a
+ * producer interrupted between claim and publish never exposes a
+ * half-written entry, and never blocks anyone but the consumer's view of
+ * the cells after it.
+ *
+ * No ESP-IDF or Contiki dependency, the queue can be driven from threads
+ * on a host.
+ */
+#ifndef EV_QUEUE_H_
+#define EV_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef EV_QUEUE_SIZE
+#define EV_QUEUE_SIZE   16           /* must be a power of two */
+#endif
+
+typedef struct {
+  void *target;                      /* e.g. the process to poll or post to */
+  uint8_t ev;
+  void *data;
+  uint32_t stamp;                    /* producer's time, for latency accounting */
+} ev_queue_entry_t;
+
+typedef struct {
+  uint32_t seq;
+  ev_queue_entry_t e;
+} ev_queue_cell_t;
+
+typedef struct {
+  ev_queue_cell_t cell[EV_QUEUE_SIZE];
+  uint32_t head;                     /* next cell a producer claims */
+  uint32_t tail;                     /* next cell the consumer reads */
+  uint32_t drops;                    /* pushes refused because the queue was full */
+} ev_queue_t;
+
+_Static_assert((EV_QUEUE_SIZE & (EV_QUEUE_SIZE - 1)) == 0, "EV_QUEUE_SIZE must be a power of two");
+
+/*---------------------------------------------------------------------------*/
+static inline void
+ev_queue_init(ev_queue_t *q)
+{
+  for(uint32_t i = 0; i < EV_QUEUE_SIZE; i++) {
+    q->cell[i].seq = i;
+  }
+  q->head = 0;
+  q->tail = 0;
+  q->drops = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Any producer: false (and drops++) when the queue is full                  */
+static inline bool
+ev_queue_push(ev_queue_t *q, const ev_queue_entry_t *e)
+{
+  uint32_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+  ev_queue_cell_t *c;
+
+  while(1) {
+    int32_t dif;
+    c = &q->cell[pos & (EV_QUEUE_SIZE - 1)];
+    dif = (int32_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+    if(dif == 0) {
+      /* free for this lap: claim it, pos is reloaded if another producer won */
+      if(__atomic_compare_exchange_n(&q->head, &pos, pos + 1, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if(dif < 0) {
+      /* still holds an entry from the previous lap */
+      __atomic_fetch_add(&q->drops, 1, __ATOMIC_RELAXED);
+      return false;
+    } else {
+      pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+    }
+  }
+  c->e = *e;
+  __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Consumer: oldest complete entry into *e, false when there is none         */
+static inline bool
+ev_queue_pop(ev_queue_t *q, ev_queue_entry_t *e)
+{
+  ev_queue_cell_t *c = &q->cell[q->tail & (EV_QUEUE_SIZE - 1)];
+
+  if(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) != q->tail + 1) {
+    return false;
+  }
+  *e = c->e;
+  __atomic_store_n(&c->seq, q->tail + EV_QUEUE_SIZE, __ATOMIC_RELEASE);
+  q->tail++;
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Consumer: true if the next pop returns an entry. A cell that a producer
+   has claimed but not yet published does not count.                       */
+static inline bool
+ev_queue_ready(ev_queue_t *q)
+{
+  ev_queue_cell_t *c = &q->cell[q->tail & (EV_QUEUE_SIZE - 1)];
+
+  return __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) == q->tail + 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Cells claimed and not yet popped, published or not                       */
+static inline unsigned
+ev_queue_count(ev_queue_t *q)
+{
+  return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) - q->tail;
+}
+/*---------------------------------------------------------------------------*/
+#endif /* EV_QUEUE_H_ */
@@ -0,0 +1,102 @@
+/* isr-bridge.c - replay polls and events queued outside the Contiki task */
+#include "contiki.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "contiki-task.h"
+#include "isr-bridge.h"
+#include <string.h>
+
+#ifdef ESP32C6_ISR_BRIDGE_CONF_SIZE
+#define EV_QUEUE_SIZE ESP32C6_ISR_BRIDGE_CONF_SIZE
+#else
+#define EV_QUEUE_SIZE 16
+#endif
+#include "ev-queue.h"
+
+static ev_queue_t queue;
+static isr_bridge_stats_t bridge_stats;
+/*---------------------------------------------------------------------------*/
+static IRAM_ATTR bool
+bridge_push(struct process *p, process_event_t ev, process_data_t data)
+{
+  ev_queue_entry_t e = {
+    .target = p,
+    .ev = ev,
+    .data = data,
+    .stamp = (uint32_t)esp_timer_get_time()
+  };
+  bool ok = ev_queue_push(&queue, &e);
+
+  if(xPortInIsrContext()) {
+    BaseType_t woken = pdFALSE;
+    contiki_task_wake_from_isr(&woken);
+    portYIELD_FROM_ISR(woken);
+  } else {
+    contiki_task_wake();
+  }
+  return ok;
+}
+/*---------------------------------------------------------------------------*/
+IRAM_ATTR bool
+isr_bridge_poll(struct process *p)
+{
+  return bridge_push(p, PROCESS_EVENT_POLL, NULL);
+}
+/*---------------------------------------------------------------------------*/
+IRAM_ATTR bool
+isr_bridge_post(struct process *p, process_event_t ev, process_data_t data)
+{
+  return bridge_push(p, ev, data);
+}
+/*---------------------------------------------------------------------------*/
+void
+isr_bridge_init(void)
+{
+  ev_queue_init(&queue);
+}
+/*---------------------------------------------------------------------------*/
+void
+isr_bridge_drain(void)
+{
+  ev_queue_entry_t e;
+  unsigned waiting = ev_queue_count(&queue);
+
+  if(waiting > bridge_stats.high_water) {
+    bridge_stats.high_water = waiting;
+  }
+  while(ev_queue_pop(&queue, &e)) {
+    uint32_t us = (uint32_t)esp_timer_get_time() - e.stamp;
+
+    bridge_stats.replayed++;
+    bridge_stats.latency_sum_us += us;
+    if(us > bridge_stats.latency_max_us) {
+      bridge_stats.latency_max_us = us;
+    }
+    if(e.ev == PROCESS_EVENT_POLL) {
+      process_poll(e.target);
+    } else if(process_post(e.target, e.ev, e.data) != PROCESS_ERR_OK) {
+      bridge_stats.post_errors++;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+bool
+isr_bridge_pending(void)
+{
+  /* not ev_queue_count(): a producer task preempted between claiming a
+     cell and publishing it would keep the Contiki task from ever blocking,
+     and so from ever letting that producer run again */
+  return ev_queue_ready(&queue);
+}
+/*---------------------------------------------------------------------------*/
+void
+isr_bridge_get_stats(isr_bridge_stats_t *stats, bool reset)
+{
+  *stats = bridge_stats;
+  stats->drops = queue.drops;
+  if(reset) {
+    memset(&bridge_stats, 0, sizeof(bridge_stats));
+    queue.drops = 0;
+  }
+}
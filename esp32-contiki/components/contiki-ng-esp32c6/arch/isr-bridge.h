@@ -0,0 +1,37 @@
+/* isr-bridge.h - process polls and events from outside the Contiki task
+ *
+ * Contiki's process list is not safe against concurrent access. ISRs,
+ * rtimer callbacks and other FreeRTOS tasks must not call process_poll() or
+ * process_post() directly. Instead they queue the request here. The queue
+ * is lock-free, see ev-queue.h. These calls also wake the Contiki task,
+ * which replays the queue with the real calls at the top of its loop.
+ */
+#ifndef ISR_BRIDGE_H_
+#define ISR_BRIDGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "contiki.h"
+
+typedef struct {
+  uint32_t replayed;            /* requests handed to Contiki */
+  uint32_t drops;               /* queue full, the request was lost */
+  uint32_t post_errors;         /* process_post() refused a replayed event */
+  uint32_t high_water;          /* most entries waiting at once */
+  uint64_t latency_sum_us;      /* queued to replayed, divide by replayed */
+  uint32_t latency_max_us;
+} isr_bridge_stats_t;
+
+/* Any context, including ISRs. false if the queue was full. */
+bool isr_bridge_poll(struct process *p);
+bool isr_bridge_post(struct process *p, process_event_t ev, process_data_t data);
+
+/* Contiki task only */
+void isr_bridge_init(void);
+void isr_bridge_drain(void);
+/* A published request is waiting, checked before the task blocks. One
+   still being written is not: its producer wakes the task once it is. */
+bool isr_bridge_pending(void);
+void isr_bridge_get_stats(isr_bridge_stats_t *stats, bool reset);
+
+#endif /* ISR_BRIDGE_H_ */
@@ -0,0 +1,167 @@
+/* lpm.c - light sleep and idle accounting for the Contiki task */
+#include "contiki.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_pm.h"
+#include "sdkconfig.h"
+#include "lpm.h"
+#include <string.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+static const char *TAG = "LPM";
+
+#ifdef ESP32C6_LPM_CONF_STATS_PERIOD
+#define STATS_PERIOD ESP32C6_LPM_CONF_STATS_PERIOD
+#else
+#define STATS_PERIOD 0         /* seconds between statistics dumps, 0 disables */
+#endif
+
+#ifdef CONFIG_CONTIKI_LIGHT_SLEEP
+static esp_pm_lock_handle_t radio_lock;
+static bool radio_locked;
+#endif
+
+static esp32c6_lpm_stats_t lpm_stats;
+static uint64_t stats_since_us;
+static uint64_t idle_since_us;
+static uint64_t idle_deadline;
+
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+static uint64_t sleep_enter_us;
+#endif
+
+PROCESS(lpm_stats_process, "LPM stats");
+/*---------------------------------------------------------------------------*/
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+/* Both run with interrupts off around the sleep; esp_timer is already
+   corrected for the sleep time when exit runs */
+static IRAM_ATTR esp_err_t
+sleep_enter_cb(int64_t sleep_time_us, void *arg)
+{
+  sleep_enter_us = esp_timer_get_time();
+  return ESP_OK;
+}
+/*---------------------------------------------------------------------------*/
+static IRAM_ATTR esp_err_t
+sleep_exit_cb(int64_t sleep_time_us, void *arg)
+{
+  lpm_stats.sleep_us += esp_timer_get_time() - sleep_enter_us;
+  lpm_stats.sleeps++;
+  return ESP_OK;
+}
+#endif
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_lpm_init(void)
+{
+  stats_since_us = esp_timer_get_time();
+#ifdef CONFIG_CONTIKI_LIGHT_SLEEP
+  esp_pm_config_t pm = {
+    .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+    .min_freq_mhz = CONFIG_XTAL_FREQ,
+    .light_sleep_enable = true
+  };
+
+  ESP_ERROR_CHECK(esp_pm_configure(&pm));
+  ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "radio", &radio_lock));
+#ifdef CONFIG_PM_LIGHT_SLEEP_CALLBACKS
+  {
+    esp_pm_sleep_cbs_register_config_t cbs = {
+      .enter_cb = sleep_enter_cb,
+      .exit_cb = sleep_exit_cb,
+    };
+    ESP_ERROR_CHECK(esp_pm_light_sleep_register_cbs(&cbs));
+  }
+#endif
+  ESP_LOGI(TAG, "light sleep when idle");
+#endif
+  if(STATS_PERIOD > 0) {
+    process_start(&lpm_stats_process, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_lpm_radio(bool on)
+{
+#ifdef CONFIG_CONTIKI_LIGHT_SLEEP
+  if(radio_lock == NULL || on == radio_locked) {
+    return;
+  }
+  radio_locked = on;
+  if(on) {
+    esp_pm_lock_acquire(radio_lock);
+  } else {
+    esp_pm_lock_release(radio_lock);
+  }
+#endif
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_lpm_idle_begin(uint64_t deadline)
+{
+  idle_since_us = esp_timer_get_time();
+  idle_deadline = deadline;
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_lpm_idle_end(void)
+{
+  uint64_t now = esp_timer_get_time();
+
+  lpm_stats.idle_us += now - idle_since_us;
+  if(idle_deadline != 0 && now >= idle_deadline) {
+    uint32_t us = now - idle_deadline;
+    lpm_stats.timed_wakeups++;
+    lpm_stats.wake_latency_sum_us += us;
+    if(us > lpm_stats.wake_latency_max_us) {
+      lpm_stats.wake_latency_max_us = us;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_lpm_get_stats(esp32c6_lpm_stats_t *stats, bool reset)
+{
+  uint64_t now = esp_timer_get_time();
+
+  *stats = lpm_stats;
+  stats->elapsed_us = now - stats_since_us;
+  if(reset) {
+    memset(&lpm_stats, 0, sizeof(lpm_stats));
+    stats_since_us = now;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_lpm_dump_stats(void)
+{
+  esp32c6_lpm_stats_t s;
+  uint64_t per_s;
+
+  esp32c6_lpm_get_stats(&s, true);
+  per_s = s.elapsed_us / 1000000 ? s.elapsed_us / 1000000 : 1;
+  ESP_LOGI(TAG, "idle %llu ms/s, asleep %llu ms/s in %lu sleeps",
+           (unsigned long long)(s.idle_us / 1000 / per_s),
+           (unsigned long long)(s.sleep_us / 1000 / per_s), (unsigned long)s.sleeps);
+  ESP_LOGI(TAG, "timed wake-ups: %lu, late by avg %lu us, max %lu us",
+           (unsigned long)s.timed_wakeups,
+           (unsigned long)(s.timed_wakeups ? s.wake_latency_sum_us / s.timed_wakeups : 0),
+           (unsigned long)s.wake_latency_max_us);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(lpm_stats_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+  etimer_set(&et, STATS_PERIOD * CLOCK_SECOND);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    esp32c6_lpm_dump_stats();
+    etimer_reset(&et);
+  }
+  PROCESS_END();
+}
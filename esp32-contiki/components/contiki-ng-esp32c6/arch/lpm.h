@@ -0,0 +1,45 @@
+/* lpm.h - light sleep while Contiki is idle
+ *
+ * With CONFIG_CONTIKI_LIGHT_SLEEP the chip enters light sleep through
+ * FreeRTOS tickless idle whenever every task is blocked. contiki_task()
+ * blocks until the next etimer deadline. Pending rtimers and that deadline
+ * are esp_timer alarms, which the idle hook uses as the wake-up time.
+ * esp_timer is corrected for the time spent asleep, so clock_time() and
+ * rtimer_arch_now(), both derived from it, need no resynchronisation.
+ * The GPTimer rtimer backend is the exception: the GPTimer stops in light
+ * sleep and cannot wake the chip, so that backend holds a no-light-sleep
+ * lock and the chip never sleeps with it.
+ *
+ * The radio does not receive in light sleep. The radio driver holds a
+ * no-light-sleep lock while it is on, so sleep only happens while the radio
+ * is off, e.g. between the channel checks of radio-dc.c.
+ */
+#ifndef LPM_H_
+#define LPM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+  uint64_t elapsed_us;          /* since the last reset */
+  uint64_t idle_us;             /* contiki_task() blocked waiting for work */
+  uint64_t sleep_us;            /* in light sleep, needs CONFIG_PM_LIGHT_SLEEP_CALLBACKS */
+  uint32_t sleeps;
+  uint32_t timed_wakeups;       /* contiki_task() woken by its etimer deadline */
+  uint64_t wake_latency_sum_us; /* deadline to contiki_task() running, divide by timed_wakeups */
+  uint32_t wake_latency_max_us;
+} esp32c6_lpm_stats_t;
+
+void esp32c6_lpm_init(void);
+/* Radio on: keep the chip out of light sleep */
+void esp32c6_lpm_radio(bool on);
+
+/* Around the wait in contiki_task(); deadline is the esp_timer time of the
+   next etimer, 0 if there is none */
+void esp32c6_lpm_idle_begin(uint64_t deadline);
+void esp32c6_lpm_idle_end(void);
+
+void esp32c6_lpm_get_stats(esp32c6_lpm_stats_t *stats, bool reset);
+void esp32c6_lpm_dump_stats(void);
+
+#endif /* LPM_H_ */
@@ -0,0 +1,392 @@
+/* radio-dc.c - CSL/ContikiMAC-style receiver duty cycling for the ESP32-C6 */
+#include "contiki.h"
+#include "dev/radio.h"
+#include "net/linkaddr.h"
+#include "net/mac/framer/frame802154.h"
+#include "sys/rtimer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "radio-esp32c6.h"
+#include "radio-dc.h"
+#include "dc-sched.h"
+#include <string.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+static const char *TAG = "RADIO DC";
+
+#define RADIO esp32c6_radio_driver
+
+#if RTIMER_ARCH_GPTIMER && ESP32C6_RADIO_CONF_DUTY_CYCLE
+#error "radio-dc.c takes a mutex and waits for the radio in its rtimer callback, use the esp_timer rtimer backend"
+#endif
+
+#ifdef ESP32C6_DC_CONF_PERIOD_US
+#define DC_PERIOD_US ESP32C6_DC_CONF_PERIOD_US
+#else
+#define DC_PERIOD_US 125000     /* 8 channel checks per second */
+#endif
+
+#ifdef ESP32C6_DC_CONF_CCA_COUNT
+#define DC_CCA_COUNT ESP32C6_DC_CONF_CCA_COUNT
+#else
+#define DC_CCA_COUNT 2          /* CCAs per wake-up */
+#endif
+
+/* A repeated frame follows the ACK wait (54 symbols) and the turnaround */
+#define DC_ACK_WAIT_US      864
+#define DC_REPEAT_GAP_US    (DC_ACK_WAIT_US + 192)
+/* Time to send a frame of len bytes (FCS not counted) and wait for its ACK */
+#define DC_REPEAT_US(len)   ((6 + (len) + 2) * 32 + DC_REPEAT_GAP_US)
+
+/* The radio is on from the first CCA to the end of the last one. That must
+   span the gap between two repeated frames: a frame on the air is seen by
+   a CCA, one that starts in between is received. */
+#define DC_CCA_US           128
+#define DC_CCA_GAP_US       1000
+#define DC_CCA_WINDOW_US    (DC_CCA_COUNT * DC_CCA_GAP_US)
+#if DC_CCA_COUNT * DC_CCA_US + (DC_CCA_COUNT - 1) * DC_CCA_GAP_US <= DC_REPEAT_GAP_US
+#error "ESP32C6_DC_CONF_CCA_COUNT: the channel checks do not span the gap between repeated frames"
+#endif
+
+#ifdef ESP32C6_DC_CONF_LISTEN_US
+#define DC_LISTEN_US ESP32C6_DC_CONF_LISTEN_US
+#else
+#define DC_LISTEN_US 10000      /* stay on this long after activity, extended while receiving */
+#endif
+
+/* A sender with a known neighbour phase starts this early, covering clock
+   drift and the time the receiver needs for its CCAs */
+#define DC_GUARD_US         2000
+
+#define DC_NEIGHBORS        8
+
+typedef struct {
+  linkaddr_t addr;
+  uint32_t phase;
+  bool used;
+} dc_neighbor_t;
+
+static dc_neighbor_t neighbors[DC_NEIGHBORS];
+static uint8_t neighbor_next;   /* replaced next when the table is full */
+
+static struct rtimer wake_timer;
+static SemaphoreHandle_t radio_lock;  /* wake-ups vs. transmit() */
+static dc_sched_t sched;        /* this node's phase and listen window */
+static volatile bool dc_enabled;
+
+/* from the last prepare() */
+static bool tx_ack_required;
+static linkaddr_t tx_dest;
+
+static esp32c6_dc_stats_t dc_stats;
+
+static void wake(struct rtimer *t, void *ptr);
+/*---------------------------------------------------------------------------*/
+static dc_neighbor_t *
+neighbor_lookup(const linkaddr_t *addr)
+{
+  for(int i = 0; i < DC_NEIGHBORS; i++) {
+    if(neighbors[i].used && linkaddr_cmp(&neighbors[i].addr, addr)) {
+      return &neighbors[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+neighbor_update(const linkaddr_t *addr, uint32_t phase)
+{
+  dc_neighbor_t *n = neighbor_lookup(addr);
+
+  if(n == NULL) {
+    n = &neighbors[neighbor_next];
+    neighbor_next = (neighbor_next + 1) % DC_NEIGHBORS;
+    linkaddr_copy(&n->addr, addr);
+    n->used = true;
+  }
+  n->phase = phase;
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule_wake(rtimer_clock_t at)
+{
+  rtimer_set(&wake_timer, at, 1, wake, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static bool
+activity(void)
+{
+  return RADIO.receiving_packet() || RADIO.pending_packet();
+}
+/*---------------------------------------------------------------------------*/
+/* rtimer callback: periodic channel check, or the end of a listen window */
+static void
+wake(struct rtimer *t, void *ptr)
+{
+  int64_t now = esp_timer_get_time();
+  uint64_t next;
+
+  if(!dc_enabled) {
+    return;
+  }
+  /* transmit() owns the radio, check again next period */
+  if(xSemaphoreTake(radio_lock, 0) != pdTRUE) {
+    sched.listening = false;
+    schedule_wake(dc_next_wake(now, sched.period, sched.phase));
+    return;
+  }
+
+  if(sched.listening) {
+    next = dc_after_listen(&sched, now, activity());
+  } else {
+    bool busy = false;
+
+    dc_stats.wakeups++;
+    RADIO.on();
+    for(int i = 0; i < DC_CCA_COUNT && !busy; i++) {
+      if(i > 0) {
+        esp_rom_delay_us(DC_CCA_GAP_US);
+      }
+      busy = !RADIO.channel_clear() || activity();
+    }
+    if(busy) {
+      dc_stats.busy_wakeups++;
+    }
+    next = dc_after_check(&sched, esp_timer_get_time(), busy);
+  }
+  if(!sched.listening) {
+    RADIO.off();
+  }
+  xSemaphoreGive(radio_lock);
+  schedule_wake(next);
+}
+/*---------------------------------------------------------------------------*/
+static void
+wait_until(int64_t t)
+{
+  int64_t left = t - esp_timer_get_time();
+
+  if(left > portTICK_PERIOD_MS * 1000) {
+    vTaskDelay(left / (portTICK_PERIOD_MS * 1000));
+    left = t - esp_timer_get_time();
+  }
+  if(left > 0) {
+    esp_rom_delay_us(left);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  radio_lock = xSemaphoreCreateMutex();
+  sched.period = DC_PERIOD_US;
+  sched.listen = DC_LISTEN_US;
+  sched.phase = esp_random() % DC_PERIOD_US;
+  return RADIO.init();
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short len)
+{
+  frame802154_t frame;
+
+  tx_ack_required = false;
+  linkaddr_copy(&tx_dest, &linkaddr_null);
+  if(frame802154_parse((uint8_t *)payload, len, &frame) > 0) {
+    tx_ack_required = frame.fcf.ack_required;
+    if(frame.fcf.dest_addr_mode == FRAME802154_LONGADDRMODE) {
+      linkaddr_copy(&tx_dest, (linkaddr_t *)frame.dest_addr);
+    }
+  }
+  return RADIO.prepare(payload, len);
+}
+/*---------------------------------------------------------------------------*/
+/* Repeat the frame until it is acknowledged, or for a whole period (plus the
+   receivers' CCA window) when no ACK is expected. */
+static int
+transmit(unsigned short len)
+{
+  int64_t start = esp_timer_get_time();
+  int64_t deadline;
+  dc_neighbor_t *n = NULL;
+  int ret;
+  uint32_t us;
+
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  dc_stats.tx_frames++;
+  if(tx_ack_required && !linkaddr_cmp(&tx_dest, &linkaddr_null)) {
+    n = neighbor_lookup(&tx_dest);
+  }
+  if(n != NULL) {
+    /* the receiver's wake-up is known, sleep until just before it */
+    wait_until(dc_strobe_start(esp_timer_get_time(), DC_PERIOD_US, n->phase, DC_GUARD_US));
+    dc_stats.phase_hits++;
+  }
+  deadline = esp_timer_get_time() +
+    dc_strobe_len(DC_PERIOD_US, DC_GUARD_US, DC_CCA_WINDOW_US, DC_REPEAT_US(len), n != NULL);
+
+  RADIO.on();
+  do {
+    ret = RADIO.transmit(len);
+    dc_stats.strobes++;
+    if(ret == RADIO_TX_ERR || (tx_ack_required && ret == RADIO_TX_OK)) {
+      break;
+    }
+  } while(esp_timer_get_time() < deadline);
+
+  if(!tx_ack_required && ret != RADIO_TX_ERR) {
+    ret = RADIO_TX_OK;               /* repeated for a whole period */
+  } else if(ret == RADIO_TX_OK && !linkaddr_cmp(&tx_dest, &linkaddr_null)) {
+    /* the receiver was awake when this frame went out */
+    neighbor_update(&tx_dest,
+                    dc_phase_from_ack(esp32c6_radio_get_tx_timestamp(), DC_PERIOD_US,
+                                      DC_GUARD_US, DC_REPEAT_US(len)));
+  } else if(n != NULL && ret == RADIO_TX_NOACK) {
+    n->used = false;                 /* phase lost, repeat for a full period next time */
+  }
+  if(!sched.listening) {
+    RADIO.off();
+  }
+  xSemaphoreGive(radio_lock);
+
+  us = esp_timer_get_time() - start;
+  if(ret == RADIO_TX_OK) {
+    dc_stats.tx_ok++;
+  }
+  dc_stats.tx_latency_sum_us += us;
+  if(us > dc_stats.tx_latency_max_us) {
+    dc_stats.tx_latency_max_us = us;
+  }
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static int
+send(const void *payload, unsigned short len)
+{
+  prepare(payload, len);
+  return transmit(len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+read(void *buf, unsigned short size)
+{
+  return RADIO.read(buf, size);
+}
+/*---------------------------------------------------------------------------*/
+/* The MAC's calls below share the radio with wake(), which runs its CCAs
+   from the esp_timer task: take the lock as transmit() does */
+static int
+channel_clear(void)
+{
+  int ret;
+
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  ret = RADIO.channel_clear();
+  xSemaphoreGive(radio_lock);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  int ret;
+
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  ret = RADIO.receiving_packet();
+  xSemaphoreGive(radio_lock);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  int ret;
+
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  ret = RADIO.pending_packet();
+  xSemaphoreGive(radio_lock);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+/* on() from the MAC starts duty cycling, the radio itself stays asleep */
+static int
+on(void)
+{
+  if(!dc_enabled) {
+    dc_enabled = true;
+    ESP_LOGI(TAG, "duty cycling, period %u us, phase %u us",
+             (unsigned)DC_PERIOD_US, (unsigned)sched.phase);
+    RADIO.off();
+    schedule_wake(dc_next_wake(esp_timer_get_time(), sched.period, sched.phase));
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  dc_enabled = false;
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  sched.listening = false;
+  RADIO.off();
+  xSemaphoreGive(radio_lock);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* RADIO_PARAM_RSSI may run an energy scan, and the channel must not change
+   under a CCA */
+static radio_result_t
+get_value(radio_param_t p, radio_value_t *v)
+{
+  radio_result_t ret;
+
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  ret = RADIO.get_value(p, v);
+  xSemaphoreGive(radio_lock);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t p, radio_value_t v)
+{
+  radio_result_t ret;
+
+  xSemaphoreTake(radio_lock, portMAX_DELAY);
+  ret = RADIO.set_value(p, v);
+  xSemaphoreGive(radio_lock);
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t p, void *dest, size_t size)
+{
+  return RADIO.get_object(p, dest, size);
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t p, const void *src, size_t size)
+{
+  return RADIO.set_object(p, src, size);
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_dc_get_stats(esp32c6_dc_stats_t *stats, bool reset)
+{
+  *stats = dc_stats;
+  if(reset) {
+    memset(&dc_stats, 0, sizeof(dc_stats));
+  }
+}
+/*---------------------------------------------------------------------------*/
+
+const struct radio_driver esp32c6_dc_radio_driver = {
+  init, prepare, transmit, send, read,
+  channel_clear, receiving_packet, pending_packet,
+  on, off, get_value, set_value, get_object, set_object
+};
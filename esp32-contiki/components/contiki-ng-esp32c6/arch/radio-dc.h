@@ -0,0 +1,35 @@
+/* radio-dc.h - receiver duty cycling on top of the ESP32-C6 radio driver
+ *
+ * esp32c6_dc_radio_driver wraps esp32c6_radio_driver. The radio sleeps
+ * except for a short channel check every ESP32C6_DC_CONF_PERIOD_US. A
+ * sender repeats its frame until it is acknowledged, or for one period for
+ * broadcasts. It then remembers when the receiver woke up, so the next
+ * frame to that neighbour is sent just before its next wake-up.
+ *
+ * Select it with ESP32C6_RADIO_CONF_DUTY_CYCLE 1. Radio-on time is in
+ * esp32c6_radio_get_state_stats(). The latency added by waiting for the
+ * receiver is tracked here.
+ */
+#ifndef RADIO_DC_H_
+#define RADIO_DC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dev/radio.h"
+
+extern const struct radio_driver esp32c6_dc_radio_driver;
+
+typedef struct {
+  uint32_t wakeups;           /* scheduled channel checks */
+  uint32_t busy_wakeups;      /* ... that found activity and kept the radio on */
+  uint32_t tx_frames;         /* frames handed to transmit() */
+  uint32_t tx_ok;
+  uint32_t strobes;           /* transmissions on air, including repeats */
+  uint32_t phase_hits;        /* unicasts sent on a known neighbour phase */
+  uint64_t tx_latency_sum_us; /* transmit() call to ACK or end of the broadcast */
+  uint32_t tx_latency_max_us;
+} esp32c6_dc_stats_t;
+
+void esp32c6_dc_get_stats(esp32c6_dc_stats_t *stats, bool reset);
+
+#endif /* RADIO_DC_H_ */
@@ -3,11 +3,31 @@
 #include "dev/radio.h"
 #include "net/packetbuf.h"
 #include "net/netstack.h"
+#include "net/linkaddr.h"
+#include "net/mac/framer/frame802154.h"
+#include "net/ipv6/uip.h"
+#if MAC_CONF_WITH_TSCH
+#include "net/mac/tsch/tsch.h"
+#if RTIMER_ARCH_GPTIMER
+#error "TSCH calls transmit() and channel_clear() from its rtimer callbacks, which wait for the radio, use the esp_timer rtimer backend"
+#endif
+#endif
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_ieee802154.h"         /* APIs */
 #include "esp_ieee802154_types.h"   /* data structures & cb typedefs */
-#include "esp_timer.h" 
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_random.h"
+#include "esp_rom_sys.h"
+#include "sdkconfig.h"
+#include "radio-esp32c6.h"
+#include "radio-trace.h"
+#include "txpower-adapt.h"
+#include "sniffer.h"
+#include "contiki-task.h"
+#include "lpm.h"
+#include "isr-bridge.h"
 
 #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 #include "esp_log.h"
@@ -15,7 +35,22 @@
 
 static const char *TAG = "ESP RADIO";
 
-#define RX_BUF_LEN     128     /* MAC max 127 + CRC */
+#ifdef ESP32C6_RADIO_CONF_RX_RING_SIZE
+#define RX_RING_SIZE   ESP32C6_RADIO_CONF_RX_RING_SIZE
+#endif
+#include "rx-ring.h"
+
+/* Each queued frame pins one of the driver's RX buffers, keep at least one free to receive into */
+#if defined(CONFIG_IEEE802154_RX_BUFFER_SIZE) && RX_RING_SIZE >= CONFIG_IEEE802154_RX_BUFFER_SIZE
+#error "ESP32C6_RADIO_CONF_RX_RING_SIZE must be smaller than CONFIG_IEEE802154_RX_BUFFER_SIZE"
+#endif
+
+#define RX_BUF_LEN     RX_RING_FRAME_LEN
+
+/* TX/CCA/ED completion is signalled on a notification index of its own */
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= ESP32C6_RADIO_NOTIFY_INDEX
+#error "CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES must be at least 2, see sdkconfig.defaults"
+#endif
 
 /* Log configuration */
 #include "sys/log.h"
@@ -25,23 +60,202 @@ static const char *TAG = "ESP RADIO";
 
 /*---------------------------------------------------------------------------*/
 PROCESS(esp_ieee802154_process, "ESP32-C6 radio");
+PROCESS(radio_stats_process, "ESP32-C6 radio stats");
+PROCESS(radio_ed_process, "ESP32-C6 radio ED");
 /*---------------------------------------------------------------------------*/
 
-/* RX bookkeeping */
-static uint8_t  rx_buf[RX_BUF_LEN];
-static uint16_t rx_len;
-static volatile bool rx_pending;
-static int8_t  rx_rssi;
-static uint8_t rx_lqi;
-static uint8_t tx_status = RADIO_TX_ERR;
-static uint32_t rx_timestamp;  /* in us, from the radio's internal timer */
+/* RX bookkeeping: frames are queued by the ISR and drained by the process */
+static rx_ring_t rx_ring;
+static uint32_t rx_frames;
+static uint64_t rx_isr_cycles;   /* queueing a frame in the ISR */
+static uint64_t rx_copy_cycles;  /* copying a frame out and releasing the driver buffer */
+static uint32_t polled_reads;
+static uint64_t read_latency_sum_us;
+static uint32_t read_latency_max_us;
+static uint32_t input_frames;
+static uint64_t input_latency_sum_us;
+static uint32_t input_latency_max_us;
+static rtimer_clock_t last_packet_timestamp;   /* SFD of the last frame handed out */
+static volatile rtimer_clock_t last_tx_timestamp;
+static esp32c6_radio_isr_stat_t isr_stats[ESP32C6_RADIO_EVENT_NUM];
+
+#ifdef ESP32C6_RADIO_CONF_STATS_PERIOD
+#define STATS_PERIOD ESP32C6_RADIO_CONF_STATS_PERIOD
+#else
+#define STATS_PERIOD 0         /* seconds between statistics dumps, 0 disables */
+#endif
+
+#define SHR_PHR_LEN  6         /* preamble, SFD and length byte, on air before the PSDU */
+
+static uint32_t rx_failed;
+static uint32_t rx_fail_code[ESP32C6_RADIO_RX_FAIL_CODES];
+static uint64_t rx_airtime_us;
+static uint64_t tx_airtime_us;
+static uint16_t tx_air_len;    /* PSDU length of the frame on air, for tx_airtime_us */
+static uint32_t rssi_hist[ESP32C6_RADIO_RSSI_BINS];
+static uint32_t lqi_hist[ESP32C6_RADIO_LQI_BINS];
+static uint32_t tx_latency_hist[ESP32C6_RADIO_LATENCY_BINS];
+static int8_t  last_rssi;
+static uint8_t last_lqi;
+
+/* TX bookkeeping: the ISR sets tx_status and notifies the waiting task */
+static volatile uint8_t tx_status = RADIO_TX_ERR;
+static TaskHandle_t tx_waiter;
+static int64_t tx_start_us;
+static esp32c6_radio_tx_stats_t tx_stats;
+
+#ifdef ESP32C6_RADIO_CONF_TX_TIMEOUT_MS
+#define TX_TIMEOUT_MS ESP32C6_RADIO_CONF_TX_TIMEOUT_MS
+#else
+#define TX_TIMEOUT_MS 20       /* longest frame + ACK wait is ~5 ms */
+#endif
+
+#ifdef ESP32C6_RADIO_CONF_TX_BUSY_WAIT
+#define TX_BUSY_WAIT ESP32C6_RADIO_CONF_TX_BUSY_WAIT
+#else
+#define TX_BUSY_WAIT 0         /* 1: old 1 ms polling wait, for comparison only */
+#endif
+
+#ifdef ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE
+#define ASYNC_TX_QUEUE ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE
+#else
+#define ASYNC_TX_QUEUE 0       /* frames queued by esp32c6_radio_send_async(), 0 disables */
+#endif
+
+#ifdef ESP32C6_RADIO_CONF_CCA_RETRIES
+#define CCA_RETRIES ESP32C6_RADIO_CONF_CCA_RETRIES
+#else
+#define CCA_RETRIES 0          /* extra CCA attempts with random backoff when SEND_ON_CCA is set */
+#endif
+#define BACKOFF_PERIOD_US   320   /* aUnitBackoffPeriod, 20 symbols */
+#define MIN_BE              3
+#define MAX_BE              5
+#define CCA_TIMEOUT_US      1000  /* CCA itself takes 8 symbols (128 us) */
+
+static radio_value_t tx_mode;        /* RADIO_TX_MODE_* flags */
+static radio_value_t rx_mode = RADIO_RX_MODE_ADDRESS_FILTER | RADIO_RX_MODE_AUTOACK;
+
+/* Output power range of the ESP32-C6 802.15.4 PHY */
+#define TXPOWER_MIN         -24
+#define TXPOWER_MAX         20
+
+/* Timing constants, in rtimer ticks (1 us). The delays are measured from the
+   call into the driver to the SFD on air / the radio listening. */
+#define PHY_OVERHEAD        3     /* preamble-less header: length byte + FCS */
+#define BYTE_AIR_TIME       32    /* 250 kbit/s */
+#ifdef ESP32C6_RADIO_CONF_DELAY_BEFORE_TX
+#define DELAY_BEFORE_TX ESP32C6_RADIO_CONF_DELAY_BEFORE_TX
+#else
+#define DELAY_BEFORE_TX     352   /* RX->TX turnaround (192 us) + SHR (160 us) */
+#endif
+#ifdef ESP32C6_RADIO_CONF_DELAY_BEFORE_RX
+#define DELAY_BEFORE_RX ESP32C6_RADIO_CONF_DELAY_BEFORE_RX
+#else
+#define DELAY_BEFORE_RX     192   /* TX->RX turnaround */
+#endif
+#define DELAY_BEFORE_DETECT 160   /* SHR: 4 byte preamble + SFD */
+static TaskHandle_t cca_waiter;
+static TaskHandle_t ed_waiter;
+static volatile int8_t ed_power;
+
+#ifdef ESP32C6_RADIO_CONF_ED_PERIOD_MS
+#define ED_PERIOD_MS ESP32C6_RADIO_CONF_ED_PERIOD_MS
+#else
+#define ED_PERIOD_MS 0         /* background noise sampling, 0 disables */
+#endif
+#ifdef ESP32C6_RADIO_CONF_ED_ALL_CHANNELS
+#define ED_ALL_CHANNELS ESP32C6_RADIO_CONF_ED_ALL_CHANNELS
+#else
+#define ED_ALL_CHANNELS 1      /* also visit the other channels, one per period */
+#endif
+#ifdef ESP32C6_RADIO_CONF_RSSI_MAX_AGE_MS
+#define RSSI_MAX_AGE_MS ESP32C6_RADIO_CONF_RSSI_MAX_AGE_MS
+#else
+#define RSSI_MAX_AGE_MS 100    /* RADIO_PARAM_RSSI reuses a sample this young */
+#endif
+#define ED_DURATION         8     /* symbols, 128 us at 16 us each, same as a CCA */
+#define ED_TIMEOUT_US       1000
+#define ED_IDLE_GAP_US      5000  /* only sample after this long without RX/TX */
+#define ED_RETRY_MS         20
+
+static esp32c6_radio_noise_t noise[ESP32C6_RADIO_CHANNELS];
+static volatile bool cca_free;
+static esp32c6_radio_cca_stats_t cca_stats;
+
+#ifdef ESP32C6_RADIO_CONF_COORDINATOR
+#define COORDINATOR ESP32C6_RADIO_CONF_COORDINATOR
+#else
+#define COORDINATOR 0          /* 1: frame-pending bit in ACKs to data requests set by hardware */
+#endif
+#ifdef CONFIG_IEEE802154_PENDING_TABLE_SIZE
+#define PENDING_TABLE_SIZE CONFIG_IEEE802154_PENDING_TABLE_SIZE
+#else
+#define PENDING_TABLE_SIZE 20
+#endif
+
+#ifdef ESP32C6_RADIO_CONF_TXPOWER_ADAPT
+#define TXPOWER_ADAPT ESP32C6_RADIO_CONF_TXPOWER_ADAPT
+#else
+#define TXPOWER_ADAPT 0        /* 1: per-neighbour power for unicasts, see txpower-adapt.h */
+#endif
+#ifdef ESP32C6_RADIO_CONF_SNIFFER
+#define SNIFFER ESP32C6_RADIO_CONF_SNIFFER
+#else
+#define SNIFFER 0              /* 1: promiscuous, receive only, frames go to the UART, see sniffer.h */
+#endif
+
+static int8_t txpower_default;     /* RADIO_PARAM_TXPOWER, used for everything else */
+static volatile int8_t last_ack_rssi;
+
+/* Mirror of the hardware pending table. An address stays in hardware while
+   it has explicit references or was added automatically after a NOACK. */
+typedef struct {
+  uint8_t addr[8];             /* little-endian, as the hardware wants it */
+  bool is_short;
+  bool auto_set;
+  uint8_t count;
+} pending_entry_t;
+static pending_entry_t pending_table[PENDING_TABLE_SIZE];
+static bool coordinator;
+
+#if ASYNC_TX_QUEUE
+typedef struct {
+  uint8_t frame[RX_BUF_LEN];
+  esp32c6_radio_tx_cb_t cb;
+  void *ptr;
+  uint8_t dest[8];                 /* set when the frame goes on air */
+  bool dest_short;
+  bool unicast;
+} async_tx_t;
+static async_tx_t async_q[ASYNC_TX_QUEUE];
+static uint8_t async_head, async_cnt;  /* only touched from Contiki context */
+static volatile bool async_active;     /* async_q[async_head] is on the air */
+static volatile bool async_done;       /* set by the ISR, handled by the process */
+static volatile bool async_pending;    /* queued, but the radio was busy when it was to start */
+static void async_tx_kick(void);
+static void async_tx_complete(void);
+#endif
+static radio_result_t set_rx_mode(radio_value_t v);
 
 enum radio_state_e {
   RADIO_STATE_RECEIVING,
   RADIO_STATE_TRANSMITTING,
   RADIO_STATE_IDLE,
-  RADIO_STATE_OFF
-} radio_state = RADIO_STATE_IDLE;
+  RADIO_STATE_OFF,
+  RADIO_STATE_NUM
+};
+static volatile enum radio_state_e radio_state = RADIO_STATE_IDLE;
+
+/* Longest time a reception can last after SFD: length byte + 127 byte PSDU at
+   32 us per byte, plus turnaround and an auto-ACK (12 symbols + 11 bytes) */
+#define RX_FRAME_MAX_US     ((1 + 127) * 32 + 192 + 11 * 32)
+
+/* State transitions happen both in the radio ISRs and in task context */
+static portMUX_TYPE state_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t state_since_us;
+static uint64_t state_time_us[RADIO_STATE_NUM];
+static uint32_t state_transitions;
+static uint32_t rx_timeouts;
 
 static char *
 get_state_string(void)
@@ -55,125 +269,360 @@ get_state_string(void)
   }
 } /* state_string() */
 
-static uint64_t sfd_time_us = 0; /* Timestamp when SFD was received */
-static enum radio_state_e get_radio_state(void)
+static int64_t sfd_time_us = 0; /* Timestamp when SFD was received */
+
+/* Move to state 'to' if the current state is 'from' (or from any state when
+   'from' is RADIO_STATE_NUM) and account the time spent in the old state.
+   Safe to call from the radio ISRs. */
+static IRAM_ATTR bool
+radio_state_change(enum radio_state_e from, enum radio_state_e to)
+{
+  bool changed = false;
+  int64_t now = esp_timer_get_time();
+
+  portENTER_CRITICAL_SAFE(&state_lock);
+  if(from == RADIO_STATE_NUM || radio_state == from) {
+    state_time_us[radio_state] += now - state_since_us;
+    state_since_us = now;
+    if(radio_state != to) {
+      state_transitions++;
+    }
+    if(to == RADIO_STATE_RECEIVING) {
+      sfd_time_us = now;
+    }
+    radio_state = to;
+    changed = true;
+  }
+  portEXIT_CRITICAL_SAFE(&state_lock);
+#if ASYNC_TX_QUEUE
+  /* the radio is free again: let the process start the frame that waited */
+  if(changed && to == RADIO_STATE_IDLE && async_pending) {
+    isr_bridge_poll(&esp_ieee802154_process);
+  }
+#endif
+  return changed;
+} /* radio_state_change() */
+
+static enum radio_state_e
+get_radio_state(void)
 {
   if(radio_state == RADIO_STATE_RECEIVING) {
-    if(esp_timer_get_time() - sfd_time_us > 1000) {
-      /* If we have not received SFD in a while, assume we are idle */
-      radio_state = RADIO_STATE_IDLE;
-      ESP_EARLY_LOGI(TAG, "Radio state changed to IDLE due to timeout");
+    esp_ieee802154_state_t hw = esp_ieee802154_get_state();
+    /* A frame normally ends with rx_done or receive_failed. If neither came
+       (e.g. a filtered frame), release the state once the longest possible
+       frame is over, or as soon as the driver has left RX. */
+    if(hw == ESP_IEEE802154_RADIO_SLEEP || hw == ESP_IEEE802154_RADIO_DISABLE ||
+       esp_timer_get_time() - sfd_time_us > RX_FRAME_MAX_US) {
+      if(radio_state_change(RADIO_STATE_RECEIVING, RADIO_STATE_IDLE)) {
+        rx_timeouts++;
+      }
     }
   }
   return radio_state;
 } /* get_radio_state() */
 
+/* Offset between the radio timer that stamps frames and esp_timer, which is
+   also the rtimer clock. Each received frame gives a sample: esp_timer at the
+   RX ISR minus the frame's airtime, minus the radio's SFD stamp. Interrupt
+   latency can only make a sample larger, so the minimum over a window is the
+   best estimate. The arithmetic is modulo 2^32 like the radio timer. */
+#define TS_CAL_WINDOW       16
+static uint32_t ts_offset;
+static bool ts_offset_valid;
+static uint32_t ts_win_min, ts_win_max;
+static uint32_t ts_win_n;
+static uint32_t ts_samples;
+static uint32_t ts_spread;
+
+static IRAM_ATTR uint64_t
+radio_ts_to_rtimer(uint32_t ts, size_t phy_len, int64_t now)
+{
+  /* length byte + PSDU on air after the SFD */
+  uint32_t sample = (uint32_t)(now - (int64_t)(1 + phy_len) * 32) - ts;
+
+  if(ts_win_n == 0 ||
+     (int32_t)(sample - ts_win_min) < 0) {
+    ts_win_min = sample;
+  }
+  if(ts_win_n == 0 ||
+     (int32_t)(sample - ts_win_max) > 0) {
+    ts_win_max = sample;
+  }
+  ts_samples++;
+  if(++ts_win_n == TS_CAL_WINDOW || !ts_offset_valid) {
+    ts_offset = ts_win_min;
+    ts_spread = ts_win_max - ts_win_min;
+    ts_offset_valid = true;
+    if(ts_win_n == TS_CAL_WINDOW) {
+      ts_win_n = 0;
+    }
+  } else if((int32_t)(sample - ts_offset) < 0) {
+    ts_offset = sample;          /* a better sample is used right away */
+  }
+  /* the frame is at most a few ms old, so the 32-bit difference is unambiguous */
+  return now - (uint32_t)((uint32_t)now - (ts + ts_offset));
+}
+
+/* Queue a driver RX buffer without copying it. Returns false if the buffer was
+   not queued, in which case it has already been handed back to the driver. */
 static bool
-add_packet_to_buf(const uint8_t *data, size_t len, int8_t rssi, uint8_t lqi, uint32_t timestamp)
+add_packet_to_buf(uint8_t *frame, int8_t rssi, uint8_t lqi,
+                  uint32_t timestamp, uint8_t channel)
 {
-  if(len > RX_BUF_LEN) {
-    ESP_LOGE(TAG, "Packet too long: %u bytes", (unsigned int)len);
+  size_t len = frame[0];         /* PHY length, includes the FCS */
+  rx_desc_t *d;
+
+  if(len < 2 || len > RX_BUF_LEN) {
+    rx_ring.drops++;
+    esp_ieee802154_receive_handle_done(frame);
     return false;
   }
-  memcpy(rx_buf, data, len);
-  rx_len = len;
-  rx_rssi = rssi;
-  rx_lqi = lqi;
-  rx_timestamp = timestamp;
-
-  rx_pending = true; /* Indicate that a packet is ready */
+  d = rx_ring_alloc(&rx_ring);
+  if(d == NULL) {
+    /* ring full, counted in rx_ring.overflows */
+    esp_ieee802154_receive_handle_done(frame);
+    return false;
+  }
+  d->buf = frame;
+  d->len = len - 2;              /* -2 for FCS, the length byte is not part of len */
+  d->rssi = rssi;
+  d->lqi = lqi;
+  d->timestamp = timestamp;
+  d->channel = channel;
+  {
+    int64_t now = esp_timer_get_time();
+    d->sfd_time = radio_ts_to_rtimer(timestamp, len, now);
+    d->latched_us = (uint32_t)now;
+  }
+  rx_ring_commit(&rx_ring);
   return true;
 } /* add_packet_to_buf() */
 
+/* Count a frame on its way up, before its slot is released */
+static void
+rx_account(const rx_desc_t *d)
+{
+  int bin = (d->rssi + 110) / 10;
+
+  rssi_hist[bin < 0 ? 0 : bin >= ESP32C6_RADIO_RSSI_BINS ? ESP32C6_RADIO_RSSI_BINS - 1 : bin]++;
+  lqi_hist[d->lqi * ESP32C6_RADIO_LQI_BINS / 256]++;
+  rx_airtime_us += (SHR_PHR_LEN + d->len + 2) * 32;
+  rx_frames++;
+}
+
+/* Hand the oldest queued buffer back to the driver and free its slot */
+static void
+release_packet(void)
+{
+  rx_desc_t *d = rx_ring_peek(&rx_ring);
+  esp_ieee802154_receive_handle_done(d->buf);
+  rx_ring_release(&rx_ring);
+} /* release_packet() */
+
 static int
 get_packet_from_buf(uint8_t *buf, unsigned int len)
 {
-  if(!rx_pending) {
-    ESP_LOGE(TAG, "No packet available");
+  uint32_t start = esp_cpu_get_cycle_count();
+  rx_desc_t *d = rx_ring_peek(&rx_ring);
+  int rx_len;
+
+  if(d == NULL) {
     return 0;
   }
+  rx_len = d->len;
   if(len < rx_len) {
     ESP_LOGE(TAG, "Buffer too small: %u < %u", (unsigned int)len, (unsigned int)rx_len);
-    return 0;
+    rx_len = 0;
+  } else {
+    memcpy(buf, d->buf + 1, rx_len);
+    last_rssi = d->rssi;
+    last_lqi = d->lqi;
+    last_packet_timestamp = d->sfd_time;
   }
-  memcpy(buf, rx_buf, rx_len);
-
-  rx_pending = false; /* Clear the pending flag */
-  return len;
+  if(rx_mode & RADIO_RX_MODE_POLL_MODE) {
+    uint32_t us = (uint32_t)esp_timer_get_time() - d->latched_us;
+    polled_reads++;
+    read_latency_sum_us += us;
+    if(us > read_latency_max_us) {
+      read_latency_max_us = us;
+    }
+  }
+  rx_account(d);
+  release_packet();              /* a frame that does not fit is dropped */
+  rx_copy_cycles += esp_cpu_get_cycle_count() - start;
+  return rx_len;
 } /* get_packet_from_buf() */
 
+/*---------------------------------------------------------------------------*/
+static IRAM_ATTR void
+isr_account(esp32c6_radio_event_t ev, uint32_t start)
+{
+  uint32_t cycles = esp_cpu_get_cycle_count() - start;
+  esp32c6_radio_isr_stat_t *st = &isr_stats[ev];
+
+  st->calls++;
+  st->sum_cycles += cycles;
+  if(cycles > st->max_cycles) {
+    st->max_cycles = cycles;
+  }
+}
 /*---------------------------------------------------------------------------*/
 /* ISR-level callback from the Espressif driver                              */
 static IRAM_ATTR void
 rx_done_cb(uint8_t *frame, esp_ieee802154_frame_info_t *info)
 {
-  /* info->len includes FCS */
+  uint32_t start = esp_cpu_get_cycle_count();
+  /* frame[0] is the PHY length and includes FCS */
   size_t len = frame[0];
-  radio_state = RADIO_STATE_IDLE;
- 
-  if(len > RX_BUF_LEN) return;               /* drop oversize */
-  /* remove lenght byte */
-  add_packet_to_buf(frame + 1, len - 2, info->rssi, info->lqi, info->timestamp); /* -2 for length byte and FCS */
+  radio_state_change(RADIO_STATE_RECEIVING, RADIO_STATE_IDLE);
+
+  /* the driver buffer is released once the process has consumed the frame */
+  add_packet_to_buf(frame, info->rssi, info->lqi, info->timestamp, info->channel);
+  rx_isr_cycles += esp_cpu_get_cycle_count() - start;
 
-  ESP_EARLY_LOGI(TAG, "RX: %u bytes, RSSI %d dBm, LQI %u, timestamp %u us (channel %u)",
-                 rx_len, rx_rssi, rx_lqi, rx_timestamp, info->channel);
-  process_poll(&esp_ieee802154_process);     /* wake the driver process */
-  esp_ieee802154_receive_handle_done(frame);
+  RADIO_TRACE(ESP32C6_RADIO_EVENT_RX_DONE, len, info->rssi, info->lqi);
+  /* in poll mode the MAC picks the frame up itself with pending_packet()/read() */
+  if(!(rx_mode & RADIO_RX_MODE_POLL_MODE)) {
+    isr_bridge_poll(&esp_ieee802154_process);   /* wake the driver process */
+  }
+  isr_account(ESP32C6_RADIO_EVENT_RX_DONE, start);
 }
 /*---------------------------------------------------------------------------*/
 static IRAM_ATTR void
 rx_sfd_done_cb(void)
 {
-  /* This callback is called when the SFD of the frame is received */
-  ESP_EARLY_LOGI(TAG, "RX SFD received");
-  /* You can handle SFD events here if needed */
-  sfd_time_us = esp_timer_get_time(); /* Store the timestamp of SFD reception */
-  radio_state = RADIO_STATE_RECEIVING; /* Update state if needed */
+  uint32_t start = esp_cpu_get_cycle_count();
+
+  RADIO_TRACE(ESP32C6_RADIO_EVENT_RX_SFD, 0, 0, 0);
+  /* only a listening radio starts a reception; ACK SFDs during TX are ignored */
+  radio_state_change(RADIO_STATE_IDLE, RADIO_STATE_RECEIVING);
+  isr_account(ESP32C6_RADIO_EVENT_RX_SFD, start);
 }
 
+/*---------------------------------------------------------------------------*/
+static IRAM_ATTR void
+tx_sfd_done_cb(uint8_t *frame)
+{
+  /* the SFD has just left the antenna, esp_timer is the rtimer clock */
+  last_tx_timestamp = esp_timer_get_time();
+}
 /*---------------------------------------------------------------------------*/
 static IRAM_ATTR void ed_done_cb(int8_t power_dbm)
 {
     /* called from the interrupt handler – keep it short */
-    ESP_EARLY_LOGI(TAG, "ED: power = %d dBm (%d)", power_dbm, esp_ieee802154_get_channel());
+    uint32_t start = esp_cpu_get_cycle_count();
+    BaseType_t woken = pdFALSE;
+    RADIO_TRACE(ESP32C6_RADIO_EVENT_ED_DONE, power_dbm, esp_ieee802154_get_channel(), 0);
+    ed_power = power_dbm;
+    if(ed_waiter != NULL) {
+      xTaskNotifyIndexedFromISR(ed_waiter, ESP32C6_RADIO_NOTIFY_INDEX, ESP32C6_RADIO_NOTIFY_ED, eSetBits, &woken);
+    }
+    isr_account(ESP32C6_RADIO_EVENT_ED_DONE, start);
+    portYIELD_FROM_ISR(woken);
+}
+/*---------------------------------------------------------------------------*/
+static IRAM_ATTR void
+cca_done_cb(bool channel_free)
+{
+  BaseType_t woken = pdFALSE;
+  uint32_t start = esp_cpu_get_cycle_count();
+
+  cca_free = channel_free;
+  RADIO_TRACE(ESP32C6_RADIO_EVENT_CCA_DONE, channel_free, 0, 0);
+  if(cca_waiter != NULL) {
+    xTaskNotifyIndexedFromISR(cca_waiter, ESP32C6_RADIO_NOTIFY_INDEX, ESP32C6_RADIO_NOTIFY_CCA, eSetBits, &woken);
+  }
+  isr_account(ESP32C6_RADIO_EVENT_CCA_DONE, start);
+  portYIELD_FROM_ISR(woken);
+}
+/*---------------------------------------------------------------------------*/
+/* Called from the TX done/fail ISRs once tx_status is set                   */
+static IRAM_ATTR void
+tx_finished(void)
+{
+  BaseType_t woken = pdFALSE;
+  uint32_t us = esp_timer_get_time() - tx_start_us;
+
+  tx_stats.frames++;
+  tx_stats.latency_sum_us += us;
+  if(us > tx_stats.latency_max_us) {
+    tx_stats.latency_max_us = us;
+  }
+  {
+    int bin = 0;
+    while((us >> (7 + bin)) != 0 && bin < ESP32C6_RADIO_LATENCY_BINS - 1) {
+      bin++;
+    }
+    tx_latency_hist[bin]++;
+  }
+  if(tx_status == RADIO_TX_OK || tx_status == RADIO_TX_NOACK) {
+    tx_airtime_us += (SHR_PHR_LEN + tx_air_len) * 32;
+  }
+  switch(tx_status) {
+  case RADIO_TX_OK: tx_stats.ok++; break;
+  case RADIO_TX_NOACK: tx_stats.noack++; break;
+  case RADIO_TX_COLLISION: tx_stats.collision++; break;
+  default: tx_stats.err++; break;
+  }
+
+#if ASYNC_TX_QUEUE
+  if(async_active) {
+    async_done = true;
+    isr_bridge_poll(&esp_ieee802154_process);
+    return;
+  }
+#endif
+  if(tx_waiter != NULL) {
+    xTaskNotifyIndexedFromISR(tx_waiter, ESP32C6_RADIO_NOTIFY_INDEX, ESP32C6_RADIO_NOTIFY_TX, eSetBits, &woken);
+  }
+  portYIELD_FROM_ISR(woken);
 }
 /*---------------------------------------------------------------------------*/
 static IRAM_ATTR void tx_done_cb(const uint8_t *psdu,
                                  const uint8_t *ack,
                                  esp_ieee802154_frame_info_t *ack_info)
 {
-    ESP_EARLY_LOGI("TX", "Packet sent, ack=%s",
-                   ack ? "yes" : "no");
-    radio_state = RADIO_STATE_IDLE;
+    uint32_t start = esp_cpu_get_cycle_count();
+    radio_state_change(RADIO_STATE_TRANSMITTING, RADIO_STATE_IDLE);
     if(ack) {
-        ESP_EARLY_LOGI(TAG, "Ack received: RSSI %d dBm, LQI %u Ack Byte %02x%02x%02x%02x%02x",
-                       ack_info->rssi, ack_info->lqi, ack[0], ack[1], ack[2], ack[3], ack[4]);
+      RADIO_TRACE(ESP32C6_RADIO_EVENT_TX_DONE, 1, ack_info->rssi, ack_info->lqi);
+      last_ack_rssi = ack_info->rssi;
       tx_status = RADIO_TX_OK;
-      int len = ack[0]; /* Length byte */
-      /* Copy the ack frame to the read-buf */
-      add_packet_to_buf(ack + 1, len - 2, ack_info->rssi, ack_info->lqi, ack_info->timestamp); /* -2 for length byte and FCS */
-
-      /* Process the ack frame if needed */
-      esp_ieee802154_receive_handle_done(ack);
+      /* Queue the ack frame for read(), the buffer is released when it is consumed */
+      add_packet_to_buf((uint8_t *)ack, ack_info->rssi, ack_info->lqi, ack_info->timestamp,
+                        ack_info->channel);
     } else {
       /* Should check if we expected ACK or not... */
         tx_status = RADIO_TX_OK;
-        ESP_EARLY_LOGI("TX", "No Ack received");
+        RADIO_TRACE(ESP32C6_RADIO_EVENT_TX_DONE, 0, 0, 0);
     }
+    tx_finished();
+    isr_account(ESP32C6_RADIO_EVENT_TX_DONE, start);
 }
 /*---------------------------------------------------------------------------*/
 static IRAM_ATTR void tx_fail_cb(const uint8_t *psdu,
                                  esp_ieee802154_tx_error_t err)
 {
-    radio_state = RADIO_STATE_IDLE;
-    tx_status = RADIO_TX_ERR;
-    ESP_EARLY_LOGE("TX", "Tx failed: err=%d", err);
+    uint32_t start = esp_cpu_get_cycle_count();
+    radio_state_change(RADIO_STATE_TRANSMITTING, RADIO_STATE_IDLE);
+    switch(err) {
+    case ESP_IEEE802154_TX_ERR_NO_ACK: tx_status = RADIO_TX_NOACK; break;
+    case ESP_IEEE802154_TX_ERR_CCA_BUSY: tx_status = RADIO_TX_COLLISION; break;
+    default: tx_status = RADIO_TX_ERR; break;
+    }
+    RADIO_TRACE(ESP32C6_RADIO_EVENT_TX_FAIL, err, 0, 0);
+    tx_finished();
+    isr_account(ESP32C6_RADIO_EVENT_TX_FAIL, start);
 }
 /*---------------------------------------------------------------------------*/
 void esp_ieee802154_receive_failed(uint16_t error) { 
   /* This function can be overridden by the application to handle receive errors */
-  ESP_EARLY_LOGE(TAG, "Receive failed with error: %u", error);
-  radio_state = RADIO_STATE_IDLE;
+  uint32_t start = esp_cpu_get_cycle_count();
+  RADIO_TRACE(ESP32C6_RADIO_EVENT_RX_FAIL, error, 0, 0);
+  rx_failed++;
+  rx_fail_code[error < ESP32C6_RADIO_RX_FAIL_CODES ? error : ESP32C6_RADIO_RX_FAIL_CODES - 1]++;
+  radio_state_change(RADIO_STATE_RECEIVING, RADIO_STATE_IDLE);
+  isr_account(ESP32C6_RADIO_EVENT_RX_FAIL, start);
 }
 
 
@@ -188,8 +637,12 @@ init(void)
         .ed_done_cb = ed_done_cb,
         .rx_done_cb = rx_done_cb,
         .rx_sfd_done_cb = rx_sfd_done_cb,
+        .tx_sfd_done_cb = tx_sfd_done_cb,
+        .cca_done_cb = cca_done_cb,
     };
   ESP_ERROR_CHECK(esp_ieee802154_event_callback_list_register(cbs)); 
+  state_since_us = esp_timer_get_time();
+  radio_trace_init();
 
   esp_ieee802154_enable();
   esp_ieee802154_set_panid(IEEE802154_CONF_PANID);
@@ -209,39 +662,248 @@ init(void)
   ESP_LOGI(TAG, "Extended address (after setting): ");
   ESP_LOG_BUFFER_HEXDUMP(TAG, eui64, sizeof(eui64), ESP_LOG_INFO);
 
+  esp32c6_lpm_radio(true);
   esp_ieee802154_receive();
   /* 4. Optionally switch on promiscuous mode to ignore PAN filters */
   ESP_ERROR_CHECK(esp_ieee802154_set_promiscuous(false));
   ESP_ERROR_CHECK(esp_ieee802154_set_rx_when_idle(true));
-  ESP_ERROR_CHECK(esp_ieee802154_set_coordinator(false));
+  ESP_ERROR_CHECK(esp32c6_radio_set_coordinator(COORDINATOR));
+  txpower_default = esp_ieee802154_get_txpower();
+  txpower_adapt_init(TXPOWER_MIN, TXPOWER_MAX, txpower_default);
+  if(SNIFFER) {
+    set_rx_mode(0);
+    sniffer_init();
+  }
 
   /* 5. Start the Contiki process */
   process_start(&esp_ieee802154_process, NULL);
+  if(STATS_PERIOD > 0) {
+    process_start(&radio_stats_process, NULL);
+  }
+  if(ED_PERIOD_MS > 0 && !SNIFFER) {
+    process_start(&radio_ed_process, NULL);
+  }
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+/* Frames are handed to the MAC by the process unless the MAC polls for them */
+static bool
+rx_for_process(void)
+{
+  return !(rx_mode & RADIO_RX_MODE_POLL_MODE) && !rx_ring_empty(&rx_ring);
+}
+/*---------------------------------------------------------------------------*/
 PROCESS_THREAD(esp_ieee802154_process, ev, data)
 {
+  rx_desc_t *d;
+#if ASYNC_TX_QUEUE
+  static struct etimer async_retry;
+#endif
+
   PROCESS_BEGIN();
-  rx_pending = false;  /* reset before input() to avoid re-entrancy */
   ESP_LOGI(TAG, "ESP32 Radio Process starting...");
 
   while(1) {
-    PROCESS_YIELD_UNTIL(rx_pending);
-    packetbuf_copyfrom(rx_buf, rx_len);
-    rx_pending = false;  /* reset before input() to avoid re-entrancy */
-    ESP_LOGI(TAG, "RX: %u bytes", rx_len);
-    ESP_LOG_BUFFER_HEXDUMP(TAG, rx_buf, rx_len, ESP_LOG_DEBUG);
+#if ASYNC_TX_QUEUE
+    PROCESS_YIELD_UNTIL(rx_for_process() || async_done || async_pending);
+    if(async_done) {
+      async_tx_complete();
+    }
+    if(async_pending) {
+      async_tx_kick();
+      if(async_pending) {
+        /* a reception that ends without rx_done only times out when the
+           state is looked at, so look again on the next tick */
+        etimer_set(&async_retry, 1);
+      }
+    }
+#else
+    PROCESS_YIELD_UNTIL(rx_for_process());
+#endif
+    if(rx_mode & RADIO_RX_MODE_POLL_MODE) {
+      continue;                    /* frames belong to read() */
+    }
+
+    /* drain everything the ISR queued since the last poll */
+    while((d = rx_ring_peek(&rx_ring)) != NULL) {
+      uint32_t start = esp_cpu_get_cycle_count();
+      uint32_t latched, us;
+      if(SNIFFER) {
+        sniffer_frame(d->buf + 1, d->len, d->channel, d->rssi, d->lqi,
+                      d->sfd_time, rx_ring.overflows);
+        rx_account(d);
+        release_packet();
+        continue;
+      }
+      /* the only copy: driver buffer straight into packetbuf */
+      packetbuf_clear();
+      packetbuf_copyfrom(d->buf + 1, d->len);
+      ESP_LOGD(TAG, "RX: %u bytes", d->len);
+      ESP_LOG_BUFFER_HEXDUMP(TAG, d->buf + 1, d->len, ESP_LOG_DEBUG);
 
-    packetbuf_set_attr(PACKETBUF_ATTR_RSSI, rx_rssi);
-    NETSTACK_MAC.input();
+      last_rssi = d->rssi;
+      last_lqi = d->lqi;
+      last_packet_timestamp = d->sfd_time;
+      packetbuf_set_attr(PACKETBUF_ATTR_RSSI, d->rssi);
+      /* attributes are 16 bits wide, the full value is LAST_PACKET_TIMESTAMP */
+      packetbuf_set_attr(PACKETBUF_ATTR_TIMESTAMP, (uint16_t)d->sfd_time);
+      packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, d->lqi);
+      packetbuf_set_attr(PACKETBUF_ATTR_CHANNEL, d->channel);
+      latched = d->latched_us;
+      /* release before input() so the driver can reuse the buffer meanwhile */
+      rx_account(d);
+      release_packet();
+      rx_copy_cycles += esp_cpu_get_cycle_count() - start;
 
-    rx_pending = false;
+      us = (uint32_t)esp_timer_get_time() - latched;
+      input_frames++;
+      input_latency_sum_us += us;
+      if(us > input_latency_max_us) {
+        input_latency_max_us = us;
+      }
+      NETSTACK_MAC.input();
+    }
   }
   PROCESS_END();
 }
 /*---------------------------------------------------------------------------*/
-/* TX path (blocking for now)                                                 */
+/* Coordinator pending table                                                 */
+static pending_entry_t *
+pending_find(const uint8_t *le, bool is_short)
+{
+  for(int i = 0; i < PENDING_TABLE_SIZE; i++) {
+    pending_entry_t *e = &pending_table[i];
+    if((e->count > 0 || e->auto_set) && e->is_short == is_short &&
+       memcmp(e->addr, le, is_short ? 2 : 8) == 0) {
+      return e;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Contiki and frame802154 keep addresses big-endian, the radio little-endian */
+static void
+pending_addr_le(uint8_t *le, const uint8_t *addr, bool is_short)
+{
+  int n = is_short ? 2 : 8;
+  for(int i = 0; i < n; i++) {
+    le[i] = addr[n - 1 - i];
+  }
+}
+/*---------------------------------------------------------------------------*/
+static pending_entry_t *
+pending_get(const uint8_t *le, bool is_short)
+{
+  pending_entry_t *e = pending_find(le, is_short);
+
+  if(e != NULL) {
+    return e;
+  }
+  for(int i = 0; i < PENDING_TABLE_SIZE; i++) {
+    e = &pending_table[i];
+    if(e->count == 0 && !e->auto_set) {
+      if(esp_ieee802154_add_pending_addr(le, is_short) != ESP_OK) {
+        return NULL;
+      }
+      memcpy(e->addr, le, is_short ? 2 : 8);
+      e->is_short = is_short;
+      return e;
+    }
+  }
+  ESP_LOGW(TAG, "pending table full");
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+pending_put(pending_entry_t *e)
+{
+  if(e->count == 0 && !e->auto_set) {
+    esp_ieee802154_clear_pending_addr(e->addr, e->is_short);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Destination of a unicast that asks for an ACK, in Contiki byte order */
+static bool
+tx_unicast_dest(const uint8_t *frame, unsigned short len, uint8_t *addr, bool *is_short)
+{
+  frame802154_t f;
+
+  if(frame802154_parse((uint8_t *)frame, len, &f) <= 0 || !f.fcf.ack_required) {
+    return false;
+  }
+  if(f.fcf.dest_addr_mode == FRAME802154_SHORTADDRMODE) {
+    *is_short = true;
+  } else if(f.fcf.dest_addr_mode == FRAME802154_LONGADDRMODE) {
+    *is_short = false;
+  } else {
+    return false;
+  }
+  memcpy(addr, f.dest_addr, *is_short ? 2 : 8);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+static void
+pending_clear_auto(const uint8_t *le, bool is_short)
+{
+  pending_entry_t *e = pending_find(le, is_short);
+
+  if(e != NULL && e->auto_set) {
+    e->auto_set = false;
+    pending_put(e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* After a unicast: a child that did not ACK is asleep, so keep the pending
+   bit set for it until a frame to it gets through, or until the MAC has
+   given up on it (esp32c6_radio_pending_done()). */
+static void
+pending_sync(const uint8_t *addr, bool is_short, int status)
+{
+  uint8_t le[8];
+  pending_entry_t *e;
+
+  if(!coordinator) {
+    return;
+  }
+  pending_addr_le(le, addr, is_short);
+  if(status == RADIO_TX_NOACK) {
+    e = pending_get(le, is_short);
+    if(e != NULL) {
+      e->auto_set = true;
+    }
+  } else if(status == RADIO_TX_OK) {
+    pending_clear_auto(le, is_short);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Per-frame power before a transmission. Returns whether the frame is a
+   unicast with an ACK, and its destination, for tx_feedback(). */
+static bool
+tx_prepare_frame(const uint8_t *frame, unsigned short len, uint8_t *dest, bool *is_short)
+{
+  bool unicast = tx_unicast_dest(frame, len, dest, is_short);
+
+  if(TXPOWER_ADAPT && unicast) {
+    esp_ieee802154_set_txpower(txpower_adapt_get(dest, *is_short));
+  }
+  return unicast;
+}
+/*---------------------------------------------------------------------------*/
+/* Per-destination bookkeeping after a transmission */
+static void
+tx_feedback(const uint8_t *dest, bool is_short, int status)
+{
+  pending_sync(dest, is_short, status);
+  if(TXPOWER_ADAPT) {
+    if(status == RADIO_TX_OK || status == RADIO_TX_NOACK) {
+      txpower_adapt_update(dest, is_short, status == RADIO_TX_OK, last_ack_rssi);
+    }
+    /* ACKs we send go out at the current power, keep them at the default */
+    esp_ieee802154_set_txpower(txpower_default);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* TX path                                                                    */
 static uint8_t tx_buf[RX_BUF_LEN];
 static int
 prepare(const void *payload, unsigned short len)
@@ -255,19 +917,79 @@ prepare(const void *payload, unsigned short len)
 static int
 transmit(unsigned short len)
 {
-  ESP_LOGI(TAG, "TX: %u bytes", len);
-  ESP_LOG_BUFFER_HEXDUMP(TAG, rx_buf, len, ESP_LOG_DEBUG);
+  uint8_t dest[8];
+  bool dest_short = false;
+  bool unicast;
 
-  if (radio_state != RADIO_STATE_IDLE) {
+  ESP_LOGD(TAG, "TX: %u bytes", len);
+  ESP_LOG_BUFFER_HEXDUMP(TAG, tx_buf + 1, len, ESP_LOG_DEBUG);
+
+  if(SNIFFER) {
+    return RADIO_TX_ERR;          /* a sniffer stays off the air */
+  }
+  get_radio_state();              /* let a stale reception time out */
+  if(!radio_state_change(RADIO_STATE_IDLE, RADIO_STATE_TRANSMITTING)) {
     ESP_LOGE(TAG, "Radio is not idle, cannot transmit %s", get_state_string());
     return RADIO_TX_ERR;
   }
-  radio_state = RADIO_STATE_TRANSMITTING;
-  esp_ieee802154_transmit(tx_buf, false /* CSMA off for now */);
+  tx_waiter = xTaskGetCurrentTaskHandle();
+  tx_start_us = esp_timer_get_time();
+  tx_air_len = tx_buf[0];
+  unicast = tx_prepare_frame(tx_buf + 1, len, dest, &dest_short);
+
+  for(int attempt = 0; ; attempt++) {
+    /* a retry can lose the channel to an incoming frame during backoff */
+    if(attempt > 0 && !radio_state_change(RADIO_STATE_IDLE, RADIO_STATE_TRANSMITTING)) {
+      tx_status = RADIO_TX_COLLISION;
+      break;
+    }
+    ulTaskNotifyValueClearIndexed(NULL, ESP32C6_RADIO_NOTIFY_INDEX, ESP32C6_RADIO_NOTIFY_TX);  /* drop a late bit from a timed out frame */
+    /* with SEND_ON_CCA the radio does the CCA itself right before the frame */
+    esp_ieee802154_transmit(tx_buf, (tx_mode & RADIO_TX_MODE_SEND_ON_CCA) != 0);
 
-  /* Wait for the TX done callback to be called */
-  while(radio_state == RADIO_STATE_TRANSMITTING) {
-    vTaskDelay(pdMS_TO_TICKS(1));  /* Yield to other tasks */
+#if TX_BUSY_WAIT
+    while(radio_state == RADIO_STATE_TRANSMITTING) {
+      vTaskDelay(pdMS_TO_TICKS(1));  /* Yield to other tasks */
+    }
+#else
+    /* Block until tx_done_cb/tx_fail_cb notify us, typically a few hundred us
+       after the last byte, instead of sleeping in 1 ms ticks */
+    {
+      uint32_t bits = 0;
+      TickType_t start = xTaskGetTickCount();
+      TickType_t timeout = pdMS_TO_TICKS(TX_TIMEOUT_MS) + 1;
+      while(!(bits & ESP32C6_RADIO_NOTIFY_TX)) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if(elapsed >= timeout ||
+           xTaskNotifyWaitIndexed(ESP32C6_RADIO_NOTIFY_INDEX, 0, ESP32C6_RADIO_NOTIFY_TX,
+                                  &bits, timeout - elapsed) != pdTRUE) {
+          if(radio_state_change(RADIO_STATE_TRANSMITTING, RADIO_STATE_IDLE)) {
+            ESP_LOGE(TAG, "TX timeout");
+            tx_status = RADIO_TX_ERR;
+          }
+          break;
+        }
+      }
+    }
+#endif
+    if(tx_status != RADIO_TX_COLLISION || attempt >= CCA_RETRIES) {
+      break;
+    }
+    /* channel busy: random backoff as in 802.15.4 unslotted CSMA-CA, then retry */
+    {
+      int be = MIN_BE + attempt < MAX_BE ? MIN_BE + attempt : MAX_BE;
+      uint32_t backoff_us = (esp_random() % (1 << be)) * BACKOFF_PERIOD_US;
+      tx_stats.cca_retries++;
+      if(backoff_us < portTICK_PERIOD_MS * 1000) {
+        esp_rom_delay_us(backoff_us);
+      } else {
+        vTaskDelay(backoff_us / (portTICK_PERIOD_MS * 1000));
+      }
+    }
+  }
+  tx_waiter = NULL;
+  if(unicast) {
+    tx_feedback(dest, dest_short, tx_status);
   }
 
   return tx_status; /* Return the status of the transmission */
@@ -280,31 +1002,135 @@ send(const void *payload, unsigned short len)
   return (r == RADIO_TX_OK) ? transmit(len) : r;
 }
 /*---------------------------------------------------------------------------*/
+#if ASYNC_TX_QUEUE
+static void
+async_tx_start(void)
+{
+  async_tx_t *t = &async_q[async_head];
+
+  async_active = true;
+  tx_start_us = esp_timer_get_time();
+  tx_air_len = t->frame[0];
+  t->unicast = tx_prepare_frame(t->frame + 1, t->frame[0] - 2, t->dest, &t->dest_short);
+  esp_ieee802154_transmit(t->frame, (tx_mode & RADIO_TX_MODE_SEND_ON_CCA) != 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Start the head of the queue if the radio is free. Otherwise it stays
+   pending: radio_state_change() polls the process when the radio goes back
+   to idle, and the process calls this again. */
+static void
+async_tx_kick(void)
+{
+  if(async_active || async_cnt == 0) {
+    async_pending = false;
+    return;
+  }
+  /* set first, so that an ISR going idle right after the check still polls */
+  async_pending = true;
+  if(get_radio_state() == RADIO_STATE_IDLE &&
+     radio_state_change(RADIO_STATE_IDLE, RADIO_STATE_TRANSMITTING)) {
+    async_pending = false;
+    async_tx_start();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Runs in the radio process after the ISR flagged completion */
+static void
+async_tx_complete(void)
+{
+  async_tx_t *t = &async_q[async_head];
+
+  async_done = false;
+  async_active = false;
+  async_head = (async_head + 1) % ASYNC_TX_QUEUE;
+  async_cnt--;
+  if(t->unicast) {
+    tx_feedback(t->dest, t->dest_short, tx_status);
+  }
+  async_tx_kick();                 /* keep the radio busy before running the callback */
+  if(t->cb != NULL) {
+    t->cb(t->ptr, tx_status);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+esp32c6_radio_send_async(const void *payload, unsigned short len,
+                         esp32c6_radio_tx_cb_t cb, void *ptr)
+{
+  async_tx_t *t;
+
+  if(len + 2 > RX_BUF_LEN) {
+    return RADIO_TX_ERR;
+  }
+  if(async_cnt == ASYNC_TX_QUEUE) {
+    return RADIO_TX_COLLISION;     /* queue full, try again after a callback */
+  }
+  t = &async_q[(async_head + async_cnt) % ASYNC_TX_QUEUE];
+  memcpy(t->frame + 1, payload, len);
+  t->frame[0] = len + 2;           /* +2 for FCS */
+  t->cb = cb;
+  t->ptr = ptr;
+  async_cnt++;
+  async_tx_kick();
+  return RADIO_TX_OK;
+}
+#endif /* ASYNC_TX_QUEUE */
+/*---------------------------------------------------------------------------*/
 /* RX helpers used by CSMA/LLSEC                                              */
 static int
 read(void *buf, unsigned short size)         
 { 
   int len;
-  if(size < rx_len) {
-    ESP_LOGE(TAG, "Buffer too small: %u < %u", size, rx_len);
-    return 0;
-  }
+
   len = get_packet_from_buf(buf, size);
   if(!len) {
     ESP_LOGE(TAG, "Failed to get packet from buffer");
     return 0;
   } else {
-    ESP_LOGI(TAG, "Read %u bytes from RX buffer", len);
+    ESP_LOGD(TAG, "Read %u bytes from RX buffer", len);
   }
   return len;
 }
 
 
 static int
-channel_clear(void)                           
+channel_clear(void)
 {
-  /* Assume clear when not transmitting */
-  return (get_radio_state() != RADIO_STATE_TRANSMITTING);
+  uint32_t bits = 0;
+  enum radio_state_e state = get_radio_state();
+
+  if(state == RADIO_STATE_TRANSMITTING || state == RADIO_STATE_RECEIVING) {
+    return 0;
+  }
+  if(state == RADIO_STATE_OFF) {
+    return 1;                      /* nothing to measure with */
+  }
+
+  /* real CCA on demand: the radio applies the configured mode and ED threshold */
+  cca_waiter = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyValueClearIndexed(NULL, ESP32C6_RADIO_NOTIFY_INDEX, ESP32C6_RADIO_NOTIFY_CCA);
+  cca_stats.checks++;
+  if(esp_ieee802154_cca() != ESP_OK) {
+    cca_waiter = NULL;
+    return 1;
+  }
+  /* 8 symbols, shorter than a tick: spin on the notification bit */
+  {
+    int64_t start = esp_timer_get_time();
+    while(!(bits & ESP32C6_RADIO_NOTIFY_CCA) &&
+          esp_timer_get_time() - start < CCA_TIMEOUT_US) {
+      xTaskNotifyWaitIndexed(ESP32C6_RADIO_NOTIFY_INDEX, 0, ESP32C6_RADIO_NOTIFY_CCA, &bits, 0);
+    }
+  }
+  cca_waiter = NULL;
+  if(!(bits & ESP32C6_RADIO_NOTIFY_CCA)) {
+    cca_stats.timeouts++;
+    return 1;
+  }
+  if(!cca_free) {
+    cca_stats.busy++;
+  }
+  return cca_free;
 }
 
 static int
@@ -317,23 +1143,102 @@ receiving_packet(void)
 static int
 pending_packet(void)
 {
-   return rx_pending;
+  return !rx_ring_empty(&rx_ring);
 }
 /*---------------------------------------------------------------------------*/
 static int on(void)
 {
-  radio_state = RADIO_STATE_IDLE;
+  esp32c6_lpm_radio(true);       /* no reception in light sleep */
+  radio_state_change(RADIO_STATE_NUM, RADIO_STATE_IDLE);
   esp_ieee802154_receive(); 
   return 0; /* success */
 }
 /*---------------------------------------------------------------------------*/
 static int off(void) 
 { 
-  radio_state = RADIO_STATE_OFF;
+  radio_state_change(RADIO_STATE_NUM, RADIO_STATE_OFF);
   esp_ieee802154_sleep();
+  esp32c6_lpm_radio(false);
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+/* The hardware ties frame filtering and auto-ACK together: promiscuous mode
+   turns both off. Mixed settings cannot be honoured. */
+static radio_result_t
+set_rx_mode(radio_value_t v)
+{
+  bool filter = (v & RADIO_RX_MODE_ADDRESS_FILTER) != 0;
+  bool autoack = (v & RADIO_RX_MODE_AUTOACK) != 0;
+
+  if(v & ~(RADIO_RX_MODE_ADDRESS_FILTER | RADIO_RX_MODE_AUTOACK | RADIO_RX_MODE_POLL_MODE)) {
+    return RADIO_RESULT_INVALID_VALUE;
+  }
+  if(filter != autoack) {
+    return RADIO_RESULT_INVALID_VALUE;
+  }
+  if(esp_ieee802154_set_promiscuous(!filter) != ESP_OK) {
+    return RADIO_RESULT_ERROR;
+  }
+  /* called from Contiki context, so the process is not draining the ring now */
+  rx_mode = v;
+  if(!(v & RADIO_RX_MODE_POLL_MODE) && !rx_ring_empty(&rx_ring)) {
+    process_poll(&esp_ieee802154_process);   /* frames latched while polling */
+  }
+  return RADIO_RESULT_OK;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t p, void *dest, size_t size)
+{
+  switch(p) {
+  case RADIO_PARAM_64BIT_ADDR: {
+    uint8_t le[8];
+    if(size != 8 || dest == NULL) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    /* the driver keeps the address little-endian, Contiki big-endian */
+    esp_ieee802154_get_extended_address(le);
+    for(int i = 0; i < 8; i++) {
+      ((uint8_t *)dest)[i] = le[7 - i];
+    }
+    return RADIO_RESULT_OK;
+  }
+  case RADIO_PARAM_LAST_PACKET_TIMESTAMP:
+    if(size != sizeof(rtimer_clock_t) || dest == NULL) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    *(rtimer_clock_t *)dest = last_packet_timestamp;
+    return RADIO_RESULT_OK;
+#if MAC_CONF_WITH_TSCH
+  case RADIO_CONST_TSCH_TIMING:
+    if(size != sizeof(uint16_t *) || dest == NULL) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    *(const uint16_t **)dest = tsch_timeslot_timing_us_10000;
+    return RADIO_RESULT_OK;
+#endif
+  default: return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t p, const void *src, size_t size)
+{
+  switch(p) {
+  case RADIO_PARAM_64BIT_ADDR: {
+    uint8_t le[8];
+    if(size != 8 || src == NULL) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    for(int i = 0; i < 8; i++) {
+      le[i] = ((const uint8_t *)src)[7 - i];
+    }
+    return esp_ieee802154_set_extended_address(le) == ESP_OK ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
+  }
+  default: return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
 /* Parameter getters/setters (only what we support)                           */
 static radio_result_t
 get_value(radio_param_t p, radio_value_t *v)
@@ -345,16 +1250,81 @@ get_value(radio_param_t p, radio_value_t *v)
   case RADIO_PARAM_PAN_ID:
     *v = esp_ieee802154_get_panid();
     return RADIO_RESULT_OK;
+  case RADIO_PARAM_16BIT_ADDR:
+    *v = esp_ieee802154_get_short_address();
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_POWER_MODE:
+    *v = radio_state == RADIO_STATE_OFF ? RADIO_POWER_MODE_OFF : RADIO_POWER_MODE_ON;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_RX_MODE:
+    *v = rx_mode;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_TXPOWER:
+    *v = txpower_default;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_RSSI: {
+    uint8_t ch = esp_ieee802154_get_channel();
+    const esp32c6_radio_noise_t *n = &noise[ch - ESP32C6_RADIO_CHANNEL_MIN];
+    int8_t dbm;
+    /* a recent sample spares the caller a blocking ED */
+    if(n->samples > 0 && esp_timer_get_time() - n->last_us < RSSI_MAX_AGE_MS * 1000LL) {
+      *v = n->last_dbm;
+      return RADIO_RESULT_OK;
+    }
+    if(esp32c6_radio_energy_detect(ch, &dbm) == 0) {
+      *v = dbm;
+      return RADIO_RESULT_OK;
+    }
+    /* busy: an older sample is the best we have */
+    if(n->samples > 0) {
+      *v = n->last_dbm;
+      return RADIO_RESULT_OK;
+    }
+    return RADIO_RESULT_ERROR;
+  }
+  case RADIO_PARAM_LAST_RSSI:
+    *v = last_rssi;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_LINK_QUALITY:
+    *v = last_lqi;
+    return RADIO_RESULT_OK;
   case RADIO_CONST_CHANNEL_MIN:
     *v = 11;  /* IEEE 802.15.4-2015, Table 6-2 */
     return RADIO_RESULT_OK;
   case RADIO_CONST_CHANNEL_MAX:
     *v = 26;  /* IEEE 802.15.4-2015, Table 6-2 */
     return RADIO_RESULT_OK;
+  case RADIO_PARAM_TX_MODE:
+    *v = tx_mode;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CCA_THRESHOLD:
+    *v = esp_ieee802154_get_cca_threshold();
+    return RADIO_RESULT_OK;
   case RADIO_CONST_MAX_PAYLOAD_LEN:
     /* MAX - Checksum */
     *v = 127 - 2; /* IEEE 802.15.4-2015, Table 6-3 */
     return RADIO_RESULT_OK;
+  case RADIO_CONST_TXPOWER_MIN:
+    *v = TXPOWER_MIN;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_TXPOWER_MAX:
+    *v = TXPOWER_MAX;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_PHY_OVERHEAD:
+    *v = PHY_OVERHEAD;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_BYTE_AIR_TIME:
+    *v = BYTE_AIR_TIME;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_DELAY_BEFORE_TX:
+    *v = DELAY_BEFORE_TX;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_DELAY_BEFORE_RX:
+    *v = DELAY_BEFORE_RX;
+    return RADIO_RESULT_OK;
+  case RADIO_CONST_DELAY_BEFORE_DETECT:
+    *v = DELAY_BEFORE_DETECT;
+    return RADIO_RESULT_OK;
   default: return RADIO_RESULT_NOT_SUPPORTED;
   }
 }
@@ -364,17 +1334,427 @@ set_value(radio_param_t p, radio_value_t v)
 {
   switch(p) {
   case RADIO_PARAM_CHANNEL:
-    return esp_ieee802154_set_channel(v) ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
+    if(v < 11 || v > 26) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    return esp_ieee802154_set_channel(v) == ESP_OK ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
   case RADIO_PARAM_PAN_ID:
-    return esp_ieee802154_set_panid(v) ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
+    return esp_ieee802154_set_panid(v) == ESP_OK ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
+  case RADIO_PARAM_16BIT_ADDR:
+    return esp_ieee802154_set_short_address(v) == ESP_OK ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
+  case RADIO_PARAM_POWER_MODE:
+    if(v == RADIO_POWER_MODE_ON) {
+      on();
+      return RADIO_RESULT_OK;
+    }
+    if(v == RADIO_POWER_MODE_OFF) {
+      off();
+      return RADIO_RESULT_OK;
+    }
+    return RADIO_RESULT_INVALID_VALUE;
+  case RADIO_PARAM_RX_MODE:
+    return set_rx_mode(v);
+  case RADIO_PARAM_TXPOWER:
+    if(v < TXPOWER_MIN || v > TXPOWER_MAX) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    if(esp_ieee802154_set_txpower(v) != ESP_OK) {
+      return RADIO_RESULT_ERROR;
+    }
+    txpower_default = v;
+    txpower_adapt_set_default(v);
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_TX_MODE:
+    if(v & ~RADIO_TX_MODE_SEND_ON_CCA) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    tx_mode = v;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CCA_THRESHOLD:
+    if(v < -128 || v > 0) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    return esp_ieee802154_set_cca_threshold(v) == ESP_OK ? RADIO_RESULT_OK : RADIO_RESULT_ERROR;
   default: return RADIO_RESULT_NOT_SUPPORTED;
   }
 }
 /*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_rx_stats(esp32c6_radio_rx_stats_t *stats)
+{
+  stats->frames = rx_frames;
+  stats->drops = rx_ring.drops;
+  stats->overflows = rx_ring.overflows;
+  stats->in_flight = rx_ring_count(&rx_ring);
+  stats->isr_cycles = rx_isr_cycles;
+  stats->copy_cycles = rx_copy_cycles;
+  stats->polled_reads = polled_reads;
+  stats->read_latency_sum_us = read_latency_sum_us;
+  stats->read_latency_max_us = read_latency_max_us;
+  stats->input_frames = input_frames;
+  stats->input_latency_sum_us = input_latency_sum_us;
+  stats->input_latency_max_us = input_latency_max_us;
+}
+void
+esp32c6_radio_get_stats(esp32c6_radio_stats_t *stats)
+{
+  esp32c6_radio_get_rx_stats(&stats->rx);
+  esp32c6_radio_get_tx_stats(&stats->tx, false);
+  esp32c6_radio_get_cca_stats(&stats->cca, false);
+  esp32c6_radio_get_state_stats(&stats->state, false);
+  stats->rx_failed = rx_failed;
+  memcpy(stats->rx_fail_code, rx_fail_code, sizeof(rx_fail_code));
+  stats->rx_airtime_us = rx_airtime_us;
+  stats->tx_airtime_us = tx_airtime_us;
+  memcpy(stats->rssi_hist, rssi_hist, sizeof(rssi_hist));
+  memcpy(stats->lqi_hist, lqi_hist, sizeof(lqi_hist));
+  memcpy(stats->tx_latency_hist, tx_latency_hist, sizeof(tx_latency_hist));
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_reset_stats(void)
+{
+  esp32c6_radio_tx_stats_t tx;
+  esp32c6_radio_cca_stats_t cca;
+  esp32c6_radio_state_stats_t state;
+  esp32c6_radio_isr_stat_t isr[ESP32C6_RADIO_EVENT_NUM];
+
+  esp32c6_radio_get_tx_stats(&tx, true);
+  esp32c6_radio_get_cca_stats(&cca, true);
+  esp32c6_radio_get_state_stats(&state, true);
+  esp32c6_radio_get_isr_stats(isr, true);
+  rx_frames = 0;
+  rx_ring.drops = 0;
+  rx_ring.overflows = 0;
+  rx_isr_cycles = 0;
+  rx_copy_cycles = 0;
+  polled_reads = 0;
+  read_latency_sum_us = 0;
+  read_latency_max_us = 0;
+  input_frames = 0;
+  input_latency_sum_us = 0;
+  input_latency_max_us = 0;
+  rx_failed = 0;
+  memset(rx_fail_code, 0, sizeof(rx_fail_code));
+  rx_airtime_us = 0;
+  tx_airtime_us = 0;
+  memset(rssi_hist, 0, sizeof(rssi_hist));
+  memset(lqi_hist, 0, sizeof(lqi_hist));
+  memset(tx_latency_hist, 0, sizeof(tx_latency_hist));
+}
+/*---------------------------------------------------------------------------*/
+static void
+dump_hist(const char *name, const uint32_t *hist, int bins)
+{
+  char line[128];
+  int n = 0;
+
+  for(int i = 0; i < bins && n < (int)sizeof(line); i++) {
+    n += snprintf(line + n, sizeof(line) - n, " %lu", (unsigned long)hist[i]);
+  }
+  ESP_LOGI(TAG, "%s:%s", name, line);
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_dump_stats(void)
+{
+  esp32c6_radio_stats_t s;
+
+  esp32c6_radio_get_stats(&s);
+  ESP_LOGI(TAG, "rx: %lu frames, %lu failed, %lu dropped, %lu overflows, airtime %llu us",
+           (unsigned long)s.rx.frames, (unsigned long)s.rx_failed, (unsigned long)s.rx.drops,
+           (unsigned long)s.rx.overflows, (unsigned long long)s.rx_airtime_us);
+  ESP_LOGI(TAG, "rx latency: ISR to MAC input avg %lu us, max %lu us",
+           (unsigned long)(s.rx.input_frames ? s.rx.input_latency_sum_us / s.rx.input_frames : 0),
+           (unsigned long)s.rx.input_latency_max_us);
+  {
+    isr_bridge_stats_t b;
+    isr_bridge_get_stats(&b, false);
+    ESP_LOGI(TAG, "isr bridge: %lu replayed, %lu dropped, high water %lu, latency avg %lu us, max %lu us",
+             (unsigned long)b.replayed, (unsigned long)b.drops, (unsigned long)b.high_water,
+             (unsigned long)(b.replayed ? b.latency_sum_us / b.replayed : 0),
+             (unsigned long)b.latency_max_us);
+  }
+  ESP_LOGI(TAG, "tx: %lu frames, %lu ok, %lu noack, %lu cca fail, %lu err, airtime %llu us",
+           (unsigned long)s.tx.frames, (unsigned long)s.tx.ok, (unsigned long)s.tx.noack,
+           (unsigned long)s.tx.collision, (unsigned long)s.tx.err,
+           (unsigned long long)s.tx_airtime_us);
+  ESP_LOGI(TAG, "cca: %lu checks, %lu busy, %lu timeouts",
+           (unsigned long)s.cca.checks, (unsigned long)s.cca.busy, (unsigned long)s.cca.timeouts);
+  ESP_LOGI(TAG, "time: rx %llu us, tx %llu us, idle %llu us, off %llu us",
+           (unsigned long long)s.state.rx_us, (unsigned long long)s.state.tx_us,
+           (unsigned long long)s.state.idle_us, (unsigned long long)s.state.off_us);
+  dump_hist("rx fail codes", s.rx_fail_code, ESP32C6_RADIO_RX_FAIL_CODES);
+  dump_hist("rssi <-100..>=-20 dBm", s.rssi_hist, ESP32C6_RADIO_RSSI_BINS);
+  dump_hist("lqi /32", s.lqi_hist, ESP32C6_RADIO_LQI_BINS);
+  dump_hist("tx latency <128us..>=128ms", s.tx_latency_hist, ESP32C6_RADIO_LATENCY_BINS);
+#if UIP_STATISTICS
+  ESP_LOGI(TAG, "ip: %lu recv, %lu sent, %lu fwd, %lu drop; udp: %lu recv, %lu sent, %lu drop",
+           (unsigned long)uip_stat.ip.recv, (unsigned long)uip_stat.ip.sent,
+           (unsigned long)uip_stat.ip.forwarded, (unsigned long)uip_stat.ip.drop,
+           (unsigned long)uip_stat.udp.recv, (unsigned long)uip_stat.udp.sent,
+           (unsigned long)uip_stat.udp.drop);
+  ESP_LOGI(TAG, "icmp: %lu recv, %lu sent, %lu drop; nd6: %lu recv, %lu sent, %lu drop",
+           (unsigned long)uip_stat.icmp.recv, (unsigned long)uip_stat.icmp.sent,
+           (unsigned long)uip_stat.icmp.drop, (unsigned long)uip_stat.nd6.recv,
+           (unsigned long)uip_stat.nd6.sent, (unsigned long)uip_stat.nd6.drop);
+#endif
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(radio_stats_process, ev, data)
+{
+  static struct etimer et;
+
+  PROCESS_BEGIN();
+  etimer_set(&et, STATS_PERIOD * CLOCK_SECOND);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    esp32c6_radio_dump_stats();
+    etimer_reset(&et);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static void
+noise_update(uint8_t channel, int8_t dbm)
+{
+  esp32c6_radio_noise_t *n = &noise[channel - ESP32C6_RADIO_CHANNEL_MIN];
+
+  if(n->samples == 0 || dbm < n->floor_dbm) {
+    n->floor_dbm = dbm;
+  } else {
+    n->floor_dbm += (dbm - n->floor_dbm + 15) / 16;   /* rounds up, so it moves */
+  }
+  n->last_dbm = dbm;
+  n->last_us = esp_timer_get_time();
+  n->samples++;
+}
+/*---------------------------------------------------------------------------*/
+/* Runs an ED in the calling task. Another channel is visited only briefly:
+   the home channel is restored before returning. */
+int
+esp32c6_radio_energy_detect(uint8_t channel, int8_t *dbm)
+{
+  uint8_t home = esp_ieee802154_get_channel();
+  uint32_t bits = 0;
+  int64_t start;
+
+  if(channel < ESP32C6_RADIO_CHANNEL_MIN ||
+     channel >= ESP32C6_RADIO_CHANNEL_MIN + ESP32C6_RADIO_CHANNELS ||
+     get_radio_state() != RADIO_STATE_IDLE) {
+    return -1;
+  }
+  if(channel != home) {
+    esp_ieee802154_set_channel(channel);
+  }
+  ed_waiter = xTaskGetCurrentTaskHandle();
+  ulTaskNotifyValueClearIndexed(NULL, ESP32C6_RADIO_NOTIFY_INDEX, ESP32C6_RADIO_NOTIFY_ED);
+  if(esp_ieee802154_energy_detect(ED_DURATION) == ESP_OK) {
+    /* 128 us, shorter than a tick: spin on the notification bit */
+    start = esp_timer_get_time();
+    while(!(bits & ESP32C6_RADIO_NOTIFY_ED) &&
+          esp_timer_get_time() - start < ED_TIMEOUT_US) {
+      xTaskNotifyWaitIndexed(ESP32C6_RADIO_NOTIFY_INDEX, 0, ESP32C6_RADIO_NOTIFY_ED, &bits, 0);
+    }
+  }
+  ed_waiter = NULL;
+  if(channel != home) {
+    esp_ieee802154_set_channel(home);
+  }
+  esp_ieee802154_receive();        /* back to listening on the home channel */
+  if(!(bits & ESP32C6_RADIO_NOTIFY_ED)) {
+    return -1;
+  }
+  *dbm = ed_power;
+  noise_update(channel, ed_power);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_noise_floor(esp32c6_radio_noise_t table[ESP32C6_RADIO_CHANNELS])
+{
+  memcpy(table, noise, sizeof(noise));
+}
+/*---------------------------------------------------------------------------*/
+/* The radio is free for a short detour: listening, nothing queued or sent
+   recently, and no MAC polling it from a slot schedule */
+static bool
+ed_gap(void)
+{
+  int64_t now = esp_timer_get_time();
+
+  return get_radio_state() == RADIO_STATE_IDLE &&
+         !(rx_mode & RADIO_RX_MODE_POLL_MODE) &&
+         rx_ring_empty(&rx_ring) &&
+         now - sfd_time_us > ED_IDLE_GAP_US &&
+         now - tx_start_us > ED_IDLE_GAP_US;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(radio_ed_process, ev, data)
+{
+  static struct etimer et;
+  static uint8_t next_other;
+  int8_t dbm;
+  uint8_t home;
+
+  PROCESS_BEGIN();
+  etimer_set(&et, ED_PERIOD_MS * CLOCK_SECOND / 1000);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+    if(!ed_gap()) {
+      etimer_set(&et, ED_RETRY_MS * CLOCK_SECOND / 1000);
+      continue;
+    }
+    home = esp_ieee802154_get_channel();
+    esp32c6_radio_energy_detect(home, &dbm);
+    if(ED_ALL_CHANNELS) {
+      uint8_t ch = ESP32C6_RADIO_CHANNEL_MIN + next_other;
+      next_other = (next_other + 1) % ESP32C6_RADIO_CHANNELS;
+      if(ch != home && ed_gap()) {
+        esp32c6_radio_energy_detect(ch, &dbm);
+      }
+    }
+    etimer_set(&et, ED_PERIOD_MS * CLOCK_SECOND / 1000);
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_isr_stats(esp32c6_radio_isr_stat_t stats[ESP32C6_RADIO_EVENT_NUM], bool reset)
+{
+  memcpy(stats, isr_stats, sizeof(isr_stats));
+  if(reset) {
+    memset(isr_stats, 0, sizeof(isr_stats));
+  }
+}
+/*---------------------------------------------------------------------------*/
+esp_err_t
+esp32c6_radio_set_coordinator(bool on)
+{
+  esp_err_t err = esp_ieee802154_set_coordinator(on);
+
+  if(err == ESP_OK) {
+    err = esp_ieee802154_set_pending_mode(on ? ESP_IEEE802154_AUTO_PENDING_ENABLE
+                                             : ESP_IEEE802154_AUTO_PENDING_DISABLE);
+  }
+  if(err == ESP_OK) {
+    coordinator = on;
+  }
+  return err;
+}
+/*---------------------------------------------------------------------------*/
+int
+esp32c6_radio_pending_add(const uint8_t *addr, bool is_short)
+{
+  uint8_t le[8];
+  pending_entry_t *e;
+
+  pending_addr_le(le, addr, is_short);
+  e = pending_get(le, is_short);
+  if(e == NULL) {
+    return -1;
+  }
+  e->count++;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_pending_remove(const uint8_t *addr, bool is_short)
+{
+  uint8_t le[8];
+  pending_entry_t *e;
+
+  pending_addr_le(le, addr, is_short);
+  e = pending_find(le, is_short);
+  if(e != NULL && e->count > 0) {
+    e->count--;
+    pending_put(e);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_pending_done(const uint8_t *addr, bool is_short)
+{
+  uint8_t le[8];
+
+  pending_addr_le(le, addr, is_short);
+  pending_clear_auto(le, is_short);
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_pending_reset(void)
+{
+  memset(pending_table, 0, sizeof(pending_table));
+  esp_ieee802154_reset_pending_table(true);
+  esp_ieee802154_reset_pending_table(false);
+}
+/*---------------------------------------------------------------------------*/
+rtimer_clock_t
+esp32c6_radio_get_tx_timestamp(void)
+{
+  return last_tx_timestamp;
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_ts_cal(esp32c6_radio_ts_cal_t *cal)
+{
+  cal->offset_us = (int32_t)ts_offset;
+  cal->samples = ts_samples;
+  cal->spread_us = ts_spread;
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_state_stats(esp32c6_radio_state_stats_t *stats, bool reset)
+{
+  int64_t now = esp_timer_get_time();
+
+  get_radio_state();
+  portENTER_CRITICAL(&state_lock);
+  /* include the time spent so far in the current state */
+  state_time_us[radio_state] += now - state_since_us;
+  state_since_us = now;
+  stats->rx_us = state_time_us[RADIO_STATE_RECEIVING];
+  stats->tx_us = state_time_us[RADIO_STATE_TRANSMITTING];
+  stats->idle_us = state_time_us[RADIO_STATE_IDLE];
+  stats->off_us = state_time_us[RADIO_STATE_OFF];
+  stats->transitions = state_transitions;
+  stats->rx_timeouts = rx_timeouts;
+  if(reset) {
+    memset(state_time_us, 0, sizeof(state_time_us));
+    state_transitions = 0;
+    rx_timeouts = 0;
+  }
+  portEXIT_CRITICAL(&state_lock);
+}
+/*---------------------------------------------------------------------------*/
+esp_err_t
+esp32c6_radio_set_cca_mode(esp_ieee802154_cca_mode_t mode)
+{
+  return esp_ieee802154_set_cca_mode(mode);
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_cca_stats(esp32c6_radio_cca_stats_t *stats, bool reset)
+{
+  *stats = cca_stats;
+  if(reset) {
+    memset(&cca_stats, 0, sizeof(cca_stats));
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_get_tx_stats(esp32c6_radio_tx_stats_t *stats, bool reset)
+{
+  *stats = tx_stats;
+  if(reset) {
+    memset(&tx_stats, 0, sizeof(tx_stats));
+  }
+}
+/*---------------------------------------------------------------------------*/
 
 const struct radio_driver esp32c6_radio_driver = {
   init, prepare, transmit, send, read,
   channel_clear, receiving_packet, pending_packet,
-  on, off, get_value, set_value, NULL, NULL
+  on, off, get_value, set_value, get_object, set_object
 };
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,187 @@
+/* radio-esp32c6.h - ESP32-C6 specific extensions of the Contiki radio driver */
+#ifndef RADIO_ESP32C6_H_
+#define RADIO_ESP32C6_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dev/radio.h"
+#include "sys/rtimer.h"
+#include "esp_err.h"
+#include "esp_ieee802154_types.h"
+
+extern const struct radio_driver esp32c6_radio_driver;
+
+typedef struct {
+  uint32_t frames;        /* frames handed to the MAC or read() */
+  uint32_t drops;         /* frames rejected for their length */
+  uint32_t overflows;     /* frames lost because the RX ring was full */
+  uint32_t in_flight;     /* driver RX buffers currently held by the ring */
+  uint64_t isr_cycles;    /* CPU cycles spent queueing frames in the ISR */
+  uint64_t copy_cycles;   /* CPU cycles spent copying frames out, divide by frames for a per-frame cost */
+  uint32_t polled_reads;  /* frames taken by read() in poll mode */
+  uint64_t read_latency_sum_us;  /* poll mode: ISR latch to read(), divide by polled_reads */
+  uint32_t read_latency_max_us;
+  uint32_t input_frames;  /* frames the driver process handed to NETSTACK_MAC.input() */
+  uint64_t input_latency_sum_us; /* ISR latch to NETSTACK_MAC.input(), divide by input_frames */
+  uint32_t input_latency_max_us;
+} esp32c6_radio_rx_stats_t;
+
+void esp32c6_radio_get_rx_stats(esp32c6_radio_rx_stats_t *stats);
+
+typedef struct {
+  uint32_t frames;          /* transmissions completed (any result) */
+  uint32_t ok;
+  uint32_t noack;
+  uint32_t collision;       /* CCA busy, counted per attempt */
+  uint32_t cca_retries;     /* backoffs after a busy CCA */
+  uint32_t err;
+  uint64_t latency_sum_us;  /* transmit() call to TX done/fail ISR */
+  uint32_t latency_max_us;
+} esp32c6_radio_tx_stats_t;
+
+void esp32c6_radio_get_tx_stats(esp32c6_radio_tx_stats_t *stats, bool reset);
+
+/* Task notification bits used to signal TX, CCA and ED completion to the calling
+   task. They live in their own notification index: waiting on a shared
+   notification would consume a wake-up meant for the Contiki task loop,
+   which uses index 0 (contiki-task.h). */
+#define ESP32C6_RADIO_NOTIFY_INDEX 1
+#define ESP32C6_RADIO_NOTIFY_TX   (1UL << 0)
+#define ESP32C6_RADIO_NOTIFY_CCA  (1UL << 1)
+#define ESP32C6_RADIO_NOTIFY_ED   (1UL << 2)
+
+typedef struct {
+  uint32_t checks;          /* channel_clear() calls that ran a CCA */
+  uint32_t busy;            /* ... that found the channel busy */
+  uint32_t timeouts;        /* ... that got no result, reported as clear */
+} esp32c6_radio_cca_stats_t;
+
+void esp32c6_radio_get_cca_stats(esp32c6_radio_cca_stats_t *stats, bool reset);
+
+/* CCA mode used by channel_clear() and SEND_ON_CCA transmissions; the ED threshold
+   is RADIO_PARAM_CCA_THRESHOLD */
+esp_err_t esp32c6_radio_set_cca_mode(esp_ieee802154_cca_mode_t mode);
+
+typedef struct {
+  uint64_t rx_us;           /* SFD to RX done/fail */
+  uint64_t tx_us;           /* transmit() to TX done/fail, includes CCA and ACK wait */
+  uint64_t idle_us;         /* listening */
+  uint64_t off_us;
+  uint32_t transitions;
+  uint32_t rx_timeouts;     /* receptions that ended without an RX event */
+} esp32c6_radio_state_stats_t;
+
+/* Time spent in each radio state, for energy and airtime accounting */
+void esp32c6_radio_get_state_stats(esp32c6_radio_state_stats_t *stats, bool reset);
+
+/* SFD time of the last transmitted frame, in rtimer ticks. The last received
+   frame's SFD time is the RADIO_PARAM_LAST_PACKET_TIMESTAMP object. */
+rtimer_clock_t esp32c6_radio_get_tx_timestamp(void);
+
+typedef struct {
+  int32_t offset_us;        /* esp_timer minus radio timer, modulo 2^32 */
+  uint32_t samples;
+  uint32_t spread_us;       /* max - min of the last window, an upper bound on ISR jitter */
+} esp32c6_radio_ts_cal_t;
+
+void esp32c6_radio_get_ts_cal(esp32c6_radio_ts_cal_t *cal);
+
+/* Coordinator mode: ACKs to data requests from addresses in the pending table
+   carry the frame-pending bit, set by hardware in time for the ACK. The
+   default is ESP32C6_RADIO_CONF_COORDINATOR. In coordinator mode a unicast
+   that is not ACKed adds its destination to the table, and the next one that
+   is ACKed removes it again, as does esp32c6_radio_pending_done() once the
+   MAC has no frame left for it (csma-pending.c calls it for CSMA). A MAC
+   that queues frames for sleepy children can also hold references itself.
+   Addresses are in Contiki byte order (as in linkaddr_t / frame802154_t),
+   2 bytes when is_short. */
+esp_err_t esp32c6_radio_set_coordinator(bool on);
+int esp32c6_radio_pending_add(const uint8_t *addr, bool is_short);  /* -1: table full */
+void esp32c6_radio_pending_remove(const uint8_t *addr, bool is_short);
+void esp32c6_radio_pending_done(const uint8_t *addr, bool is_short);
+void esp32c6_radio_pending_reset(void);
+
+/* Radio interrupt callbacks, used as trace event IDs and ISR statistics index */
+typedef enum {
+  ESP32C6_RADIO_EVENT_RX_DONE,
+  ESP32C6_RADIO_EVENT_RX_SFD,
+  ESP32C6_RADIO_EVENT_RX_FAIL,
+  ESP32C6_RADIO_EVENT_TX_DONE,
+  ESP32C6_RADIO_EVENT_TX_FAIL,
+  ESP32C6_RADIO_EVENT_ED_DONE,
+  ESP32C6_RADIO_EVENT_CCA_DONE,
+  ESP32C6_RADIO_EVENT_NUM
+} esp32c6_radio_event_t;
+
+typedef struct {
+  uint32_t calls;
+  uint32_t max_cycles;
+  uint64_t sum_cycles;      /* time spent in our callback, CPU cycles */
+} esp32c6_radio_isr_stat_t;
+
+void esp32c6_radio_get_isr_stats(esp32c6_radio_isr_stat_t stats[ESP32C6_RADIO_EVENT_NUM],
+                                 bool reset);
+
+/* Histogram layouts: RSSI in 10 dB bins from below -100 to -20 dBm and above,
+   LQI in 8 bins of 32, TX latency in power-of-two bins from below 128 us to
+   128 ms and above */
+#define ESP32C6_RADIO_RSSI_BINS     10
+#define ESP32C6_RADIO_LQI_BINS      8
+#define ESP32C6_RADIO_LATENCY_BINS  12
+#define ESP32C6_RADIO_RX_FAIL_CODES 16  /* receive_failed() codes, the last bin takes the rest */
+
+typedef struct {
+  esp32c6_radio_rx_stats_t rx;
+  esp32c6_radio_tx_stats_t tx;
+  esp32c6_radio_cca_stats_t cca;
+  esp32c6_radio_state_stats_t state;
+  uint32_t rx_failed;
+  uint32_t rx_fail_code[ESP32C6_RADIO_RX_FAIL_CODES];
+  uint64_t rx_airtime_us;   /* frames handed up, SHR to FCS */
+  uint64_t tx_airtime_us;   /* frames that went on air */
+  uint32_t rssi_hist[ESP32C6_RADIO_RSSI_BINS];
+  uint32_t lqi_hist[ESP32C6_RADIO_LQI_BINS];
+  uint32_t tx_latency_hist[ESP32C6_RADIO_LATENCY_BINS];
+} esp32c6_radio_stats_t;
+
+/* All counters at once; reset clears every counter in this file */
+void esp32c6_radio_get_stats(esp32c6_radio_stats_t *stats);
+void esp32c6_radio_reset_stats(void);
+/* Log all counters, histograms and the uIP statistics. Also done every
+   ESP32C6_RADIO_CONF_STATS_PERIOD seconds when that is not 0. */
+void esp32c6_radio_dump_stats(void);
+
+/* Energy detection. RADIO_PARAM_RSSI returns the last sample of the current
+   channel if it is younger than ESP32C6_RADIO_CONF_RSSI_MAX_AGE_MS, and runs
+   a fresh one otherwise. With
+   ESP32C6_RADIO_CONF_ED_PERIOD_MS > 0 the driver also samples in the
+   background whenever the radio has been idle for a while, the current
+   channel every period and, with ESP32C6_RADIO_CONF_ED_ALL_CHANNELS, one
+   other channel in turn. */
+#define ESP32C6_RADIO_CHANNEL_MIN   11
+#define ESP32C6_RADIO_CHANNELS      16
+
+typedef struct {
+  int8_t floor_dbm;         /* lower envelope: follows drops at once, rises slowly */
+  int8_t last_dbm;
+  int64_t last_us;          /* esp_timer time of last_dbm */
+  uint32_t samples;         /* 0: nothing measured on this channel yet */
+} esp32c6_radio_noise_t;
+
+/* 0 and the power in dBm, or -1 when the radio is busy or off */
+int esp32c6_radio_energy_detect(uint8_t channel, int8_t *dbm);
+void esp32c6_radio_get_noise_floor(esp32c6_radio_noise_t table[ESP32C6_RADIO_CHANNELS]);
+
+/* Asynchronous TX, enabled with ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE > 0. The frame is
+   copied into a queue and sent in order; cb runs from the radio process with the
+   RADIO_TX_* result. Returns RADIO_TX_COLLISION when the queue is full. */
+typedef void (*esp32c6_radio_tx_cb_t)(void *ptr, int status);
+int esp32c6_radio_send_async(const void *payload, unsigned short len,
+                             esp32c6_radio_tx_cb_t cb, void *ptr);
+
+/* radio-tx-bench.c: with ESP32C6_RADIO_CONF_TX_BENCH set, sends that many
+   frames back to back, then as many through the async queue if it is
+   enabled, and logs frames/s and the latency histogram. A no-op otherwise. */
+void esp32c6_radio_tx_bench_start(void);
+
+#endif /* RADIO_ESP32C6_H_ */
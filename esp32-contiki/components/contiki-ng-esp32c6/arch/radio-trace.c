@@ -0,0 +1,112 @@
+/* radio-trace.c - deferred formatting of radio ISR events */
+#include "radio-trace.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <stdio.h>
+
+#if RADIO_TRACE_MODE != 0
+static const char *TAG = "RADIO TRACE";
+#endif
+
+#if RADIO_TRACE_MODE == 1
+_Static_assert((RADIO_TRACE_SIZE & (RADIO_TRACE_SIZE - 1)) == 0,
+               "RADIO_TRACE_SIZE must be a power of two");
+
+#define TRACE_PERIOD_MS   100
+
+static const char *const event_fmt[ESP32C6_RADIO_EVENT_NUM] = {
+  [ESP32C6_RADIO_EVENT_RX_DONE]  = "RX: %ld bytes, RSSI %ld dBm, LQI %ld",
+  [ESP32C6_RADIO_EVENT_RX_SFD]   = "RX SFD received",
+  [ESP32C6_RADIO_EVENT_RX_FAIL]  = "Receive failed with error: %ld",
+  [ESP32C6_RADIO_EVENT_TX_DONE]  = "Packet sent, ack=%ld, ack RSSI %ld dBm, LQI %ld",
+  [ESP32C6_RADIO_EVENT_TX_FAIL]  = "Tx failed: err=%ld",
+  [ESP32C6_RADIO_EVENT_ED_DONE]  = "ED: power = %ld dBm (%ld)",
+  [ESP32C6_RADIO_EVENT_CCA_DONE] = "CCA: channel free=%ld",
+};
+
+/* Single producer: all callbacks run from the one radio interrupt. The task
+   is the only consumer, so head and tail need no lock. */
+static radio_trace_rec_t ring[RADIO_TRACE_SIZE];
+static uint32_t head, tail;
+static uint32_t drops;
+/*---------------------------------------------------------------------------*/
+void IRAM_ATTR
+radio_trace_put(uint8_t id, int32_t a, int32_t b, int32_t c)
+{
+  radio_trace_rec_t *r;
+
+  if(head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= RADIO_TRACE_SIZE) {
+    drops++;
+    return;
+  }
+  r = &ring[head & (RADIO_TRACE_SIZE - 1)];
+  r->ts = (uint32_t)esp_timer_get_time();
+  r->id = id;
+  r->arg[0] = a;
+  r->arg[1] = b;
+  r->arg[2] = c;
+  __atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+}
+/*---------------------------------------------------------------------------*/
+static void
+trace_task(void *arg)
+{
+  uint32_t reported_drops = 0;
+
+  while(1) {
+    vTaskDelay(pdMS_TO_TICKS(TRACE_PERIOD_MS));
+    while(tail != __atomic_load_n(&head, __ATOMIC_ACQUIRE)) {
+      radio_trace_rec_t r = ring[tail & (RADIO_TRACE_SIZE - 1)];
+      char line[96];
+
+      __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+      if(r.id >= ESP32C6_RADIO_EVENT_NUM) {
+        continue;
+      }
+      snprintf(line, sizeof(line), event_fmt[r.id],
+               (long)r.arg[0], (long)r.arg[1], (long)r.arg[2]);
+      ESP_LOGI(TAG, "%lu.%06lu %s", (unsigned long)(r.ts / 1000000),
+               (unsigned long)(r.ts % 1000000), line);
+    }
+    if(drops != reported_drops) {
+      ESP_LOGW(TAG, "%lu records dropped", (unsigned long)(drops - reported_drops));
+      reported_drops = drops;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+radio_trace_init(void)
+{
+  xTaskCreate(trace_task, "radio_trace", 3072, NULL, tskIDLE_PRIORITY + 1, NULL);
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+radio_trace_drops(void)
+{
+  return drops;
+}
+#else /* RADIO_TRACE_MODE == 1 */
+/*---------------------------------------------------------------------------*/
+#if RADIO_TRACE_MODE == 2
+void IRAM_ATTR
+radio_trace_early_log(uint8_t id, int32_t a, int32_t b, int32_t c)
+{
+  ESP_EARLY_LOGI(TAG, "event %u: %ld %ld %ld", id, (long)a, (long)b, (long)c);
+}
+#endif
+/*---------------------------------------------------------------------------*/
+void
+radio_trace_init(void)
+{
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+radio_trace_drops(void)
+{
+  return 0;
+}
+#endif /* RADIO_TRACE_MODE == 1 */
@@ -0,0 +1,51 @@
+/* radio-trace.h - constant-time event trace for the radio ISRs
+ *
+ * Logging from the radio callbacks used to go through ESP_EARLY_LOG, which
+ * formats and writes to the UART inside the interrupt. RADIO_TRACE() stores
+ * an event ID, a timestamp and three integers in a ring instead. A
+ * low-priority task formats the records later.
+ *
+ * ESP32C6_RADIO_CONF_TRACE selects the mode:
+ *   0  tracing compiled out
+ *   1  deferred ring (default)
+ *   2  synchronous ESP_EARLY_LOG from the ISR, to compare ISR durations only
+ */
+#ifndef RADIO_TRACE_H_
+#define RADIO_TRACE_H_
+
+#include <stdint.h>
+#include "radio-esp32c6.h"
+
+#ifdef ESP32C6_RADIO_CONF_TRACE
+#define RADIO_TRACE_MODE ESP32C6_RADIO_CONF_TRACE
+#else
+#define RADIO_TRACE_MODE 1
+#endif
+
+#ifndef RADIO_TRACE_SIZE
+#define RADIO_TRACE_SIZE 64          /* records, must be a power of two */
+#endif
+
+typedef struct {
+  uint32_t ts;                       /* esp_timer us, low 32 bits */
+  uint8_t  id;                       /* esp32c6_radio_event_t */
+  int32_t  arg[3];
+} radio_trace_rec_t;
+
+#if RADIO_TRACE_MODE == 1
+void radio_trace_put(uint8_t id, int32_t a, int32_t b, int32_t c);
+#define RADIO_TRACE(id, a, b, c) radio_trace_put((id), (a), (b), (c))
+#elif RADIO_TRACE_MODE == 2
+void radio_trace_early_log(uint8_t id, int32_t a, int32_t b, int32_t c);
+#define RADIO_TRACE(id, a, b, c) radio_trace_early_log((id), (a), (b), (c))
+#else
+/* arguments are not evaluated, but still count as used */
+#define RADIO_TRACE(id, a, b, c) do { if(0) { (void)(a); (void)(b); (void)(c); } } while(0)
+#endif
+
+/* Starts the task that prints the ring, a no-op unless the mode is 1 */
+void radio_trace_init(void);
+/* Records lost because the ring was full */
+uint32_t radio_trace_drops(void);
+
+#endif /* RADIO_TRACE_H_ */
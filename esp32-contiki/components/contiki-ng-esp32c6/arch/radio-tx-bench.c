@@ -0,0 +1,201 @@
+/* radio-tx-bench.c - measure TX throughput and latency on the device
+ *
+ * Sends ESP32C6_RADIO_CONF_TX_BENCH broadcast frames back to back through
+ * NETSTACK_RADIO.send() and logs frames/s and a histogram of the time each
+ * send() blocked. Build once with ESP32C6_RADIO_CONF_TX_BUSY_WAIT 0 and once
+ * with 1 to compare the notification wait with the old 1 ms polling. With
+ * ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE > 0 the same number of frames then goes
+ * through esp32c6_radio_send_async() with the queue kept full, and the
+ * latency is from queueing to the callback. Lines look like
+ *
+ *   radio tx bench notify: 1000 frames in 2481 ms, 403.1 frames/s, ...
+ *   radio tx bench notify hist: <128us 0 <256us 0 ... >=128ms 0
+ *
+ * Run it on a node with no other traffic: the MAC's own frames would find
+ * the radio busy and count as errors here.
+ */
+#include "contiki.h"
+#include "net/netstack.h"
+#include "net/linkaddr.h"
+#include "radio-esp32c6.h"
+#include "esp_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+static const char *TAG = "RADIO TX BENCH";
+
+#ifdef ESP32C6_RADIO_CONF_TX_BENCH
+#define BENCH_FRAMES ESP32C6_RADIO_CONF_TX_BENCH
+#else
+#define BENCH_FRAMES 0         /* frames per mode, 0 disables the benchmark */
+#endif
+
+#if defined(ESP32C6_RADIO_CONF_TX_BUSY_WAIT) && ESP32C6_RADIO_CONF_TX_BUSY_WAIT
+#define SYNC_MODE "busy-wait"
+#else
+#define SYNC_MODE "notify"
+#endif
+#if defined(ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE) && ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE > 0
+#define BENCH_ASYNC 1
+#else
+#define BENCH_ASYNC 0
+#endif
+
+#define BENCH_FRAME_LEN  50    /* PSDU without FCS */
+#define BENCH_BATCH      100   /* sends between pauses for the rest of Contiki */
+
+#if BENCH_FRAMES > 0
+typedef struct {
+  uint32_t frames;
+  uint32_t errors;
+  int64_t busy_us;             /* time spent sending, pauses excluded */
+  uint32_t min_us, max_us;
+  uint64_t sum_us;
+  uint32_t hist[ESP32C6_RADIO_LATENCY_BINS];
+} bench_t;
+
+static bench_t bench;
+static uint8_t frame[BENCH_FRAME_LEN] = {
+  0x41, 0x88, 0,               /* data, PAN ID compression, short addresses */
+  0xcd, 0xab, 0xff, 0xff,      /* PAN, broadcast */
+  0x00, 0x00                   /* source, filled in at start */
+};
+
+PROCESS(radio_tx_bench_process, "radio tx bench");
+/*---------------------------------------------------------------------------*/
+static void
+bench_account(uint32_t us, int status)
+{
+  int bin = 0;
+
+  bench.frames++;
+  if(status != RADIO_TX_OK) {
+    bench.errors++;
+  }
+  bench.sum_us += us;
+  if(us < bench.min_us) {
+    bench.min_us = us;
+  }
+  if(us > bench.max_us) {
+    bench.max_us = us;
+  }
+  /* the driver's bins: <128 us, then doubling up to >=128 ms */
+  while((us >> (7 + bin)) != 0 && bin < ESP32C6_RADIO_LATENCY_BINS - 1) {
+    bin++;
+  }
+  bench.hist[bin]++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_report(const char *mode)
+{
+  char line[ESP32C6_RADIO_LATENCY_BINS * 16];
+  int n = 0;
+
+  ESP_LOGI(TAG, "radio tx bench %s: %lu frames in %lld ms, %.1f frames/s,"
+           " latency min %lu us, avg %lu us, max %lu us, %lu errors", mode,
+           (unsigned long)bench.frames, bench.busy_us / 1000,
+           bench.busy_us > 0 ? bench.frames * 1e6 / bench.busy_us : 0.0,
+           (unsigned long)bench.min_us,
+           (unsigned long)(bench.frames ? bench.sum_us / bench.frames : 0),
+           (unsigned long)bench.max_us, (unsigned long)bench.errors);
+  for(int i = 0; i < ESP32C6_RADIO_LATENCY_BINS; i++) {
+    if(i < ESP32C6_RADIO_LATENCY_BINS - 1) {
+      n += snprintf(line + n, sizeof(line) - n, " <%luus %lu",
+                    128UL << i, (unsigned long)bench.hist[i]);
+    } else {
+      n += snprintf(line + n, sizeof(line) - n, " >=%luus %lu",
+                    128UL << (i - 1), (unsigned long)bench.hist[i]);
+    }
+  }
+  ESP_LOGI(TAG, "radio tx bench %s hist:%s", mode, line);
+}
+/*---------------------------------------------------------------------------*/
+static void
+bench_reset(void)
+{
+  memset(&bench, 0, sizeof(bench));
+  bench.min_us = UINT32_MAX;
+}
+/*---------------------------------------------------------------------------*/
+#if BENCH_ASYNC
+#define ASYNC_STAMPS 64        /* more than any sensible queue length */
+#if ESP32C6_RADIO_CONF_ASYNC_TX_QUEUE > ASYNC_STAMPS
+#error "radio-tx-bench.c: raise ASYNC_STAMPS to the async TX queue length"
+#endif
+static uint32_t enqueued_us[ASYNC_STAMPS];
+static uint32_t queued, done;
+
+static void
+async_cb(void *ptr, int status)
+{
+  uint32_t n = (uint32_t)(uintptr_t)ptr;
+
+  bench_account((uint32_t)esp_timer_get_time() - enqueued_us[n % ASYNC_STAMPS], status);
+  done++;
+  process_poll(&radio_tx_bench_process);
+}
+#endif
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(radio_tx_bench_process, ev, data)
+{
+  static struct etimer et;
+  static uint32_t sent;
+  int64_t start;
+
+  PROCESS_BEGIN();
+  /* let the network stack finish starting up */
+  etimer_set(&et, CLOCK_SECOND);
+  PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  frame[7] = linkaddr_node_addr.u8[LINKADDR_SIZE - 1];
+  frame[8] = linkaddr_node_addr.u8[LINKADDR_SIZE - 2];
+
+  bench_reset();
+  for(sent = 0; sent < BENCH_FRAMES; ) {
+    start = esp_timer_get_time();
+    for(int i = 0; i < BENCH_BATCH && sent < BENCH_FRAMES; i++, sent++) {
+      int64_t t = esp_timer_get_time();
+      int status;
+
+      frame[2] = sent;
+      status = NETSTACK_RADIO.send(frame, sizeof(frame));
+      bench_account(esp_timer_get_time() - t, status);
+    }
+    bench.busy_us += esp_timer_get_time() - start;
+    PROCESS_PAUSE();
+  }
+  bench_report(SYNC_MODE);
+
+#if BENCH_ASYNC
+  bench_reset();
+  queued = done = 0;
+  start = esp_timer_get_time();
+  while(done < BENCH_FRAMES) {
+    while(queued < BENCH_FRAMES) {
+      frame[2] = queued;
+      enqueued_us[queued % ASYNC_STAMPS] = (uint32_t)esp_timer_get_time();
+      if(esp32c6_radio_send_async(frame, sizeof(frame), async_cb,
+                                  (void *)(uintptr_t)queued) != RADIO_TX_OK) {
+        break;                 /* queue full */
+      }
+      queued++;
+    }
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+  }
+  bench.busy_us = esp_timer_get_time() - start;
+  bench_report("async");
+#endif
+  PROCESS_END();
+}
+#endif /* BENCH_FRAMES > 0 */
+/*---------------------------------------------------------------------------*/
+void
+esp32c6_radio_tx_bench_start(void)
+{
+#if BENCH_FRAMES > 0
+  process_start(&radio_tx_bench_process, NULL);
+#endif
+}
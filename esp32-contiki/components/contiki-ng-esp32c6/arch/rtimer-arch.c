@@ -4,22 +4,107 @@
 #include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "contiki-task.h"
+#if RTIMER_ARCH_GPTIMER
+#include "driver/gptimer.h"
+#include "esp_pm.h"
+#include "sdkconfig.h"
+#endif
+#include <string.h>
 
 static const char *TAG = "rtimer";
+
+static volatile rtimer_clock_t scheduled;   /* target of the armed alarm */
+static rtimer_arch_jitter_t jitter;
+
+#if RTIMER_ARCH_GPTIMER
+/* Both the GPTimer and esp_timer count at 1 MHz, and an alarm is placed at
+   the GPTimer count read together with rtimer_arch_now() plus the time left
+   until the target. No fixed offset between the two is kept: the rtimer
+   clock wraps and the GPTimer does not, and in light sleep the GPTimer
+   stops while esp_timer is corrected for the sleep. The GPTimer cannot wake
+   the chip from light sleep either, so this backend keeps it awake. */
+static gptimer_handle_t gptimer;
+static portMUX_TYPE gptimer_lock = portMUX_INITIALIZER_UNLOCKED;
+#ifdef CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t gptimer_pm_lock;
+#endif
+/* closest alarm set ahead of the counter when the target is already due */
+#define GPTIMER_MIN_DELAY 2
+#else
 static esp_timer_handle_t rtimer_hdl;
+#endif
 
 /* ---------- internal helpers ------------------------------------- */
+static void IRAM_ATTR jitter_account(void)
+{
+  int32_t err = (int32_t)(rtimer_arch_now() - scheduled);
+  uint32_t late = err > 0 ? err : 0;
+  int bin = 0;
+
+  if(jitter.fired == 0 || err < jitter.min_us) {
+    jitter.min_us = err;
+  }
+  if(jitter.fired == 0 || err > jitter.max_us) {
+    jitter.max_us = err;
+  }
+  jitter.fired++;
+  jitter.sum_us += err;
+  while(late >> bin != 0 && bin < RTIMER_ARCH_JITTER_BINS - 1) {
+    bin++;
+  }
+  jitter.hist[bin]++;
+}
+
+#if RTIMER_ARCH_GPTIMER
+static bool IRAM_ATTR gptimer_alarm_cb(gptimer_handle_t timer,
+                                       const gptimer_alarm_event_data_t *edata,
+                                       void *arg)
+{
+  BaseType_t woken = pdFALSE;
+
+  jitter_account();
+  rtimer_run_next();
+  /* the callback may have polled a process */
+  contiki_task_wake_from_isr(&woken);
+  return woken == pdTRUE;
+}
+#else
 static void IRAM_ATTR rtimer_alarm_cb(void *arg)
 {
   /* Contiki expects this to run from interrupt context.
      esp_timer fires from a high-prio task, but that’s usually fine.
-     If you later need real ISR, switch to GPTimer (Option B). */
+     For real ISR dispatch select the GPTimer backend. */
+  jitter_account();
   rtimer_run_next();
+  /* the callback may have polled a process */
+  contiki_task_wake();
 }
+#endif
 
 /* ---------- required API ----------------------------------------- */
 void rtimer_arch_init(void)
 {
+#if RTIMER_ARCH_GPTIMER
+  gptimer_config_t cfg = {
+    .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+    .direction = GPTIMER_COUNT_UP,
+    .resolution_hz = RTIMER_ARCH_SECOND,
+  };
+  gptimer_event_callbacks_t cbs = {
+    .on_alarm = gptimer_alarm_cb,
+  };
+#ifdef CONFIG_PM_ENABLE
+  /* keep the chip out of light sleep for good, see above */
+  ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "rtimer", &gptimer_pm_lock));
+  ESP_ERROR_CHECK(esp_pm_lock_acquire(gptimer_pm_lock));
+#endif
+  ESP_ERROR_CHECK(gptimer_new_timer(&cfg, &gptimer));
+  ESP_ERROR_CHECK(gptimer_register_event_callbacks(gptimer, &cbs, NULL));
+  ESP_ERROR_CHECK(gptimer_enable(gptimer));
+  ESP_ERROR_CHECK(gptimer_start(gptimer));
+  ESP_LOGI(TAG, "GPTimer backend");
+#else
   esp_timer_create_args_t args = {
     .callback = rtimer_alarm_cb,
     .dispatch_method = ESP_TIMER_TASK,
@@ -29,6 +114,7 @@ void rtimer_arch_init(void)
   if(err != ESP_OK) {
     ESP_LOGE(TAG, "create failed (%d)", err);
   }
+#endif
 }
 
 rtimer_clock_t rtimer_arch_now(void)
@@ -39,9 +125,49 @@ rtimer_clock_t rtimer_arch_now(void)
 
 void rtimer_arch_schedule(rtimer_clock_t t)
 {
+#if RTIMER_ARCH_GPTIMER
+  uint64_t count;
+  int32_t left;
+  gptimer_alarm_config_t alarm = { 0 };
+
+  scheduled = t;
+  /* With interrupts off nothing delays us between reading the counter and
+     arming, except the counter itself: if it has reached the compare value
+     by the time the alarm is set, the alarm may never fire, so check again
+     afterwards and move it ahead of the counter. An alarm that did fire
+     meanwhile is still pending and runs once, after the critical section. */
+  portENTER_CRITICAL_SAFE(&gptimer_lock);
+  gptimer_get_raw_count(gptimer, &count);
+  left = (int32_t)(t - rtimer_arch_now());
+  alarm.alarm_count = count + (left > GPTIMER_MIN_DELAY ? left : GPTIMER_MIN_DELAY);
+  while(1) {
+    if(alarm.alarm_count < count + GPTIMER_MIN_DELAY) {
+      alarm.alarm_count = count + GPTIMER_MIN_DELAY;   /* already due → fire asap */
+    }
+    /* moves the compare value, the counter keeps running */
+    gptimer_set_alarm_action(gptimer, &alarm);
+    gptimer_get_raw_count(gptimer, &count);
+    if(count < alarm.alarm_count) {
+      break;
+    }
+  }
+  portEXIT_CRITICAL_SAFE(&gptimer_lock);
+#else
   rtimer_clock_t now = rtimer_arch_now();
   uint64_t delay_us  = (t > now) ? (t - now) : 1;   /* never 0 → fire asap */
 
-  esp_timer_stop(rtimer_hdl);              /* cancel previous alarm      */
-  esp_timer_start_once(rtimer_hdl, delay_us);
-}
\ No newline at end of file
+  scheduled = t;
+  /* restart re-arms a running timer in one call, start covers an idle one */
+  if(esp_timer_restart(rtimer_hdl, delay_us) != ESP_OK) {
+    esp_timer_start_once(rtimer_hdl, delay_us);
+  }
+#endif
+}
+
+void rtimer_arch_get_jitter(rtimer_arch_jitter_t *stats, bool reset)
+{
+  *stats = jitter;
+  if(reset) {
+    memset(&jitter, 0, sizeof(jitter));
+  }
+}
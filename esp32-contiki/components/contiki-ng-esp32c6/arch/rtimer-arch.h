@@ -2,11 +2,21 @@
 #define RTIMER_ARCH_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 
 /* 1 tick  = 1 µs, so 1 second = 1 000 000 ticks */
 #define RTIMER_ARCH_SECOND 1000000UL
 
+/* Alarm backend. 0: esp_timer, callbacks run in the esp_timer task.
+   1: GPTimer compare interrupt, callbacks run in interrupt context and
+   must not block. rtimer_arch_now() is esp_timer time with either. */
+#ifdef ESP32C6_RTIMER_CONF_GPTIMER
+#define RTIMER_ARCH_GPTIMER ESP32C6_RTIMER_CONF_GPTIMER
+#else
+#define RTIMER_ARCH_GPTIMER 0
+#endif
+
 /* ------------------------------------------------------------------ */
 /*  Architecture hooks Contiki expects                                */
 /* ------------------------------------------------------------------ */
@@ -14,4 +24,24 @@ rtimer_clock_t rtimer_arch_now(void);
 void           rtimer_arch_init(void);
 void           rtimer_arch_schedule(rtimer_clock_t t);
 
-#endif /* RTIMER_ARCH_H_ */
\ No newline at end of file
+/* ------------------------------------------------------------------ */
+/*  Firing error: time the alarm callback ran minus the scheduled time */
+/* ------------------------------------------------------------------ */
+#define RTIMER_ARCH_JITTER_BINS 12   /* late by <1, <2, <4 .. <1024, >=1024 us */
+
+typedef struct {
+  uint32_t fired;
+  int32_t  min_us;                   /* negative: fired early */
+  int32_t  max_us;
+  int64_t  sum_us;
+  uint32_t hist[RTIMER_ARCH_JITTER_BINS];
+} rtimer_arch_jitter_t;
+
+void rtimer_arch_get_jitter(rtimer_arch_jitter_t *jitter, bool reset);
+
+/* rtimer-bench.c: with ESP32C6_RTIMER_CONF_BENCH set, schedules that many
+   rtimers at random offsets and logs every firing error for
+   tools/rtimer-jitter.py. A no-op otherwise. */
+void rtimer_arch_bench_start(void);
+
+#endif /* RTIMER_ARCH_H_ */
@@ -0,0 +1,85 @@
+/* rtimer-bench.c - measure rtimer firing error on the device
+ *
+ * Schedules ESP32C6_RTIMER_CONF_BENCH rtimers back to back, each 200 us to
+ * 2.2 ms ahead at a random offset, and records how late each callback ran.
+ * The samples are logged as "rtimer bench <backend> samples: ..." lines and
+ * tools/rtimer-jitter.py turns a log with them into a distribution, e.g. to
+ * compare the esp_timer and GPTimer backends.
+ */
+#include "contiki.h"
+#include "sys/rtimer.h"
+#include "esp_random.h"
+#include "isr-bridge.h"
+#include <stdio.h>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+
+static const char *TAG = "RTIMER BENCH";
+
+#ifdef ESP32C6_RTIMER_CONF_BENCH
+#define BENCH_SAMPLES ESP32C6_RTIMER_CONF_BENCH
+#else
+#define BENCH_SAMPLES 0        /* rtimers to measure, 0 disables the benchmark */
+#endif
+
+#define BENCH_PER_LINE 16
+
+#if BENCH_SAMPLES > 0
+static int32_t samples[BENCH_SAMPLES];
+static volatile int nsamples;
+static struct rtimer bench_timer;
+static rtimer_clock_t bench_target;
+
+PROCESS(rtimer_bench_process, "rtimer bench");
+/*---------------------------------------------------------------------------*/
+static void
+bench_cb(struct rtimer *t, void *ptr)
+{
+  samples[nsamples++] = (int32_t)(RTIMER_NOW() - bench_target);
+  if(nsamples < BENCH_SAMPLES) {
+    bench_target = RTIMER_NOW() + 200 + esp_random() % 2000;
+    rtimer_set(&bench_timer, bench_target, 1, bench_cb, NULL);
+  } else {
+    isr_bridge_poll(&rtimer_bench_process);
+  }
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(rtimer_bench_process, ev, data)
+{
+  static int i;
+  rtimer_arch_jitter_t j;
+  char line[BENCH_PER_LINE * 8 + 1];
+  int n;
+
+  PROCESS_BEGIN();
+  rtimer_arch_get_jitter(&j, true);
+  nsamples = 0;
+  bench_target = RTIMER_NOW() + 1000;
+  rtimer_set(&bench_timer, bench_target, 1, bench_cb, NULL);
+  PROCESS_WAIT_UNTIL(nsamples >= BENCH_SAMPLES);
+
+  rtimer_arch_get_jitter(&j, false);
+  ESP_LOGI(TAG, "%s: %lu alarms, error min %ld us, avg %ld us, max %ld us",
+           RTIMER_ARCH_GPTIMER ? "gptimer" : "esp_timer", (unsigned long)j.fired,
+           (long)j.min_us, (long)(j.fired ? j.sum_us / j.fired : 0), (long)j.max_us);
+  for(i = 0; i < BENCH_SAMPLES; i += BENCH_PER_LINE) {
+    n = 0;
+    for(int k = i; k < i + BENCH_PER_LINE && k < BENCH_SAMPLES; k++) {
+      n += snprintf(line + n, sizeof(line) - n, " %ld", (long)samples[k]);
+    }
+    ESP_LOGI(TAG, "rtimer bench %s samples:%s",
+             RTIMER_ARCH_GPTIMER ? "gptimer" : "esp_timer", line);
+    PROCESS_PAUSE();           /* do not hog the log */
+  }
+  PROCESS_END();
+}
+#endif /* BENCH_SAMPLES > 0 */
+/*---------------------------------------------------------------------------*/
+void
+rtimer_arch_bench_start(void)
+{
+#if BENCH_SAMPLES > 0
+  process_start(&rtimer_bench_process, NULL);
+#endif
+}
@@ -0,0 +1,98 @@
+/* rx-ring.h - lock-free single-producer/single-consumer ring of received frames
+ *
+ * The radio ISR is the only producer. The consumer is the Contiki radio
+ * process, or read() when the radio is in poll mode, never both at once.
+ * head is written by the producer only and tail by the consumer only, so
+ * no lock is needed. The ring has no ESP-IDF dependency and can be driven
+ * from two threads on a host.
+ *
+ * Slots do not hold frame data. They point into the radio driver's own RX
+ * buffer, which stays owned by the ring until the consumer has copied the
+ * frame out and handed the buffer back to the driver.
+ */
+#ifndef RX_RING_H_
+#define RX_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef RX_RING_SIZE
+#define RX_RING_SIZE    8            /* must be a power of two */
+#endif
+#define RX_RING_FRAME_LEN  128       /* MAC max 127 + CRC */
+
+typedef struct {
+  uint8_t *buf;                      /* driver RX buffer, buf[0] is the PHY length byte */
+  uint16_t len;                      /* MAC frame length without FCS, data starts at buf + 1 */
+  int8_t   rssi;
+  uint8_t  lqi;
+  uint8_t  channel;
+  uint32_t timestamp;                /* us, from the radio's internal timer */
+  uint64_t sfd_time;                 /* SFD in the esp_timer/rtimer timebase (us) */
+  uint32_t latched_us;               /* esp_timer time the ISR queued the frame (low 32 bits) */
+} rx_desc_t;
+
+typedef struct {
+  rx_desc_t slot[RX_RING_SIZE];
+  uint32_t head;                     /* next slot the producer fills */
+  uint32_t tail;                     /* next slot the consumer reads */
+  uint32_t drops;                    /* frames rejected before queueing (bad length) */
+  uint32_t overflows;                /* frames lost because the ring was full */
+} rx_ring_t;
+
+_Static_assert((RX_RING_SIZE & (RX_RING_SIZE - 1)) == 0, "RX_RING_SIZE must be a power of two");
+
+/*---------------------------------------------------------------------------*/
+/* Producer: slot to fill, or NULL (and overflows++) when the ring is full.  */
+static inline rx_desc_t *
+rx_ring_alloc(rx_ring_t *r)
+{
+  uint32_t head = r->head;
+  uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+  if(head - tail >= RX_RING_SIZE) {
+    r->overflows++;
+    return NULL;
+  }
+  return &r->slot[head & (RX_RING_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+/* Producer: publish the slot returned by rx_ring_alloc()                    */
+static inline void
+rx_ring_commit(rx_ring_t *r)
+{
+  __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+/*---------------------------------------------------------------------------*/
+/* Consumer: oldest queued frame, or NULL when empty                         */
+static inline rx_desc_t *
+rx_ring_peek(rx_ring_t *r)
+{
+  uint32_t tail = r->tail;
+  if(__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail) {
+    return NULL;
+  }
+  return &r->slot[tail & (RX_RING_SIZE - 1)];
+}
+/*---------------------------------------------------------------------------*/
+/* Consumer: hand the slot returned by rx_ring_peek() back to the producer   */
+static inline void
+rx_ring_release(rx_ring_t *r)
+{
+  __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+}
+/*---------------------------------------------------------------------------*/
+static inline bool
+rx_ring_empty(rx_ring_t *r)
+{
+  return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == r->tail;
+}
+/*---------------------------------------------------------------------------*/
+static inline unsigned
+rx_ring_count(rx_ring_t *r)
+{
+  return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+/*---------------------------------------------------------------------------*/
+#endif /* RX_RING_H_ */
@@ -0,0 +1,75 @@
+/* sniffer-rec.h - record format of the sniffer UART stream
+ *
+ * Record format, little-endian:
+ *    0  u8   0xC5, 0x15       sync
+ *    2  u8   type             SNIFFER_REC_FRAME
+ *    3  u8   psdu_len         frame bytes that follow, FCS only if SNIFFER_FLAG_FCS
+ *    4  u8   channel
+ *    5  i8   rssi             dBm
+ *    6  u8   lqi
+ *    7  u8   flags            SNIFFER_FLAG_*, 0 from sniffer.c: the radio strips the FCS
+ *    8  u64  timestamp        SFD time, us since boot
+ *   16  u32  lost             frames dropped before the UART so far
+ *   20  psdu_len bytes        the frame
+ *    .  u16  crc              CRC-16/CCITT-FALSE over type .. end of frame
+ *
+ * No ESP-IDF dependency, test/sniffer-stream.c builds records on a host to
+ * check tools/sniffer2pcapng.py against.
+ */
+#ifndef SNIFFER_REC_H_
+#define SNIFFER_REC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SNIFFER_SYNC0         0xC5
+#define SNIFFER_SYNC1         0x15
+#define SNIFFER_REC_FRAME     1
+#define SNIFFER_FLAG_FCS      0x01    /* the last two frame bytes are the FCS */
+#define SNIFFER_HDR_LEN       20
+#define SNIFFER_CRC_LEN       2
+
+/*---------------------------------------------------------------------------*/
+static inline uint16_t
+sniffer_crc16(uint16_t crc, const uint8_t *p, size_t n)
+{
+  while(n--) {
+    crc ^= (uint16_t)*p++ << 8;
+    for(int i = 0; i < 8; i++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+/*---------------------------------------------------------------------------*/
+/* Fill the header of a frame record and the CRC that follows the frame      */
+static inline void
+sniffer_rec_encode(uint8_t hdr[SNIFFER_HDR_LEN], uint8_t crc[SNIFFER_CRC_LEN],
+                   const uint8_t *psdu, uint8_t psdu_len, uint8_t channel,
+                   int8_t rssi, uint8_t lqi, uint8_t flags,
+                   uint64_t timestamp, uint32_t lost)
+{
+  uint16_t c;
+
+  hdr[0] = SNIFFER_SYNC0;
+  hdr[1] = SNIFFER_SYNC1;
+  hdr[2] = SNIFFER_REC_FRAME;
+  hdr[3] = psdu_len;
+  hdr[4] = channel;
+  hdr[5] = (uint8_t)rssi;
+  hdr[6] = lqi;
+  hdr[7] = flags;
+  for(int i = 0; i < 8; i++) {
+    hdr[8 + i] = timestamp >> (8 * i);
+  }
+  for(int i = 0; i < 4; i++) {
+    hdr[16 + i] = lost >> (8 * i);
+  }
+  c = sniffer_crc16(0xffff, hdr + 2, SNIFFER_HDR_LEN - 2);
+  c = sniffer_crc16(c, psdu, psdu_len);
+  crc[0] = c;
+  crc[1] = c >> 8;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif /* SNIFFER_REC_H_ */
@@ -0,0 +1,106 @@
+/* sniffer.c - framed binary stream of received frames over the UART */
+#include "sniffer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include <string.h>
+
+#ifdef ESP32C6_SNIFFER_CONF_UART
+#define SNIFFER_UART ESP32C6_SNIFFER_CONF_UART
+#else
+#define SNIFFER_UART UART_NUM_0      /* the console UART; logging is switched off */
+#endif
+
+#ifdef ESP32C6_SNIFFER_CONF_BAUD
+#define SNIFFER_BAUD ESP32C6_SNIFFER_CONF_BAUD
+#else
+#define SNIFFER_BAUD 921600
+#endif
+
+#ifdef ESP32C6_SNIFFER_CONF_RING_SIZE
+#define RING_SIZE ESP32C6_SNIFFER_CONF_RING_SIZE
+#else
+#define RING_SIZE 16384              /* bytes, must be a power of two */
+#endif
+
+_Static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "sniffer ring size must be a power of two");
+
+/* Single producer (radio process) and single consumer (UART task) */
+static uint8_t ring[RING_SIZE];
+static uint32_t head, tail;
+static uint32_t lost;
+static TaskHandle_t uart_task;
+/*---------------------------------------------------------------------------*/
+static void
+ring_put(uint32_t at, const void *src, size_t n)
+{
+  size_t off = at & (RING_SIZE - 1);
+  size_t first = n < RING_SIZE - off ? n : RING_SIZE - off;
+
+  memcpy(&ring[off], src, first);
+  memcpy(ring, (const uint8_t *)src + first, n - first);
+}
+/*---------------------------------------------------------------------------*/
+void
+sniffer_frame(const uint8_t *psdu, uint8_t psdu_len, uint8_t channel,
+              int8_t rssi, uint8_t lqi, uint64_t timestamp, uint32_t radio_lost)
+{
+  uint8_t hdr[SNIFFER_HDR_LEN];
+  uint8_t crc[SNIFFER_CRC_LEN];
+  uint32_t total = radio_lost + lost;
+  size_t len = SNIFFER_HDR_LEN + psdu_len + SNIFFER_CRC_LEN;
+
+  if(RING_SIZE - (head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) < len) {
+    lost++;
+    return;
+  }
+  /* FCS already checked and stripped */
+  sniffer_rec_encode(hdr, crc, psdu, psdu_len, channel, rssi, lqi, 0, timestamp, total);
+
+  ring_put(head, hdr, sizeof(hdr));
+  ring_put(head + sizeof(hdr), psdu, psdu_len);
+  ring_put(head + sizeof(hdr) + psdu_len, crc, sizeof(crc));
+  __atomic_store_n(&head, head + len, __ATOMIC_RELEASE);
+  xTaskNotifyGive(uart_task);
+}
+/*---------------------------------------------------------------------------*/
+static void
+sniffer_task(void *arg)
+{
+  while(1) {
+    uint32_t h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    size_t off, n;
+
+    if(h == tail) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+      continue;
+    }
+    /* the contiguous part up to the end of the ring */
+    off = tail & (RING_SIZE - 1);
+    n = h - tail;
+    if(n > RING_SIZE - off) {
+      n = RING_SIZE - off;
+    }
+    uart_write_bytes(SNIFFER_UART, &ring[off], n);
+    __atomic_store_n(&tail, tail + n, __ATOMIC_RELEASE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+sniffer_init(void)
+{
+  /* anything else on this UART would corrupt the stream, the host resyncs on CRC */
+  esp_log_level_set("*", ESP_LOG_NONE);
+  if(!uart_is_driver_installed(SNIFFER_UART)) {
+    uart_driver_install(SNIFFER_UART, 256, 0, 0, NULL, 0);
+  }
+  uart_set_baudrate(SNIFFER_UART, SNIFFER_BAUD);
+  xTaskCreate(sniffer_task, "sniffer", 2048, NULL, tskIDLE_PRIORITY + 2, &uart_task);
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+sniffer_lost(void)
+{
+  return lost;
+}
@@ -0,0 +1,24 @@
+/* sniffer.h - stream received 802.15.4 frames over the UART
+ *
+ * With ESP32C6_RADIO_CONF_SNIFFER 1 the radio runs promiscuous and does not
+ * transmit. Every received frame goes to the UART instead of to the MAC,
+ * with its SFD timestamp, RSSI, LQI and channel. Frames are queued in a
+ * byte ring and written out by a separate task. Frames that do not fit in
+ * the ring are counted, and the count travels in every record.
+ * tools/sniffer2pcapng.py turns the stream into PCAP-NG.
+ *
+ * The record format is in sniffer-rec.h.
+ */
+#ifndef SNIFFER_H_
+#define SNIFFER_H_
+
+#include <stdint.h>
+#include "sniffer-rec.h"
+
+void sniffer_init(void);
+/* Queue one frame; called from the radio process */
+void sniffer_frame(const uint8_t *psdu, uint8_t psdu_len, uint8_t channel,
+                   int8_t rssi, uint8_t lqi, uint64_t timestamp, uint32_t radio_lost);
+uint32_t sniffer_lost(void);
+
+#endif /* SNIFFER_H_ */
@@ -0,0 +1,136 @@
+/* txpower-adapt.c - per-neighbour TX power adaptation from ACK feedback */
+#include "txpower-adapt.h"
+#include <string.h>
+
+typedef struct {
+  uint8_t addr[8];
+  bool is_short;
+  bool used;
+  int8_t power;
+  uint8_t strong;           /* consecutive ACKs above target + margin */
+  uint8_t missed;           /* consecutive missed ACKs */
+  uint32_t last_use;        /* for replacing the least recently used entry */
+} txpower_entry_t;
+
+static txpower_entry_t table[TXPOWER_ADAPT_NEIGHBORS];
+static int8_t power_min, power_max, power_default;
+static uint32_t use_clock;
+static txpower_adapt_stats_t stats;
+/*---------------------------------------------------------------------------*/
+static int8_t
+clamp(int v)
+{
+  return v < power_min ? power_min : v > power_max ? power_max : v;
+}
+/*---------------------------------------------------------------------------*/
+static txpower_entry_t *
+lookup(const uint8_t *addr, bool is_short)
+{
+  for(int i = 0; i < TXPOWER_ADAPT_NEIGHBORS; i++) {
+    txpower_entry_t *e = &table[i];
+    if(e->used && e->is_short == is_short &&
+       memcmp(e->addr, addr, is_short ? 2 : 8) == 0) {
+      return e;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static txpower_entry_t *
+lookup_or_add(const uint8_t *addr, bool is_short)
+{
+  txpower_entry_t *e = lookup(addr, is_short);
+  txpower_entry_t *victim = &table[0];
+
+  if(e != NULL) {
+    return e;
+  }
+  for(int i = 0; i < TXPOWER_ADAPT_NEIGHBORS; i++) {
+    if(!table[i].used) {
+      victim = &table[i];
+      break;
+    }
+    if(table[i].last_use < victim->last_use) {
+      victim = &table[i];
+    }
+  }
+  if(victim->used) {
+    stats.evictions++;
+  }
+  memset(victim, 0, sizeof(*victim));
+  memcpy(victim->addr, addr, is_short ? 2 : 8);
+  victim->is_short = is_short;
+  victim->used = true;
+  victim->power = power_default;
+  return victim;
+}
+/*---------------------------------------------------------------------------*/
+void
+txpower_adapt_init(int8_t min_dbm, int8_t max_dbm, int8_t default_dbm)
+{
+  memset(table, 0, sizeof(table));
+  memset(&stats, 0, sizeof(stats));
+  power_min = min_dbm;
+  power_max = max_dbm;
+  power_default = clamp(default_dbm);
+}
+/*---------------------------------------------------------------------------*/
+void
+txpower_adapt_set_default(int8_t default_dbm)
+{
+  power_default = clamp(default_dbm);
+}
+/*---------------------------------------------------------------------------*/
+int8_t
+txpower_adapt_get(const uint8_t *addr, bool is_short)
+{
+  txpower_entry_t *e = lookup(addr, is_short);
+
+  if(e == NULL) {
+    return power_default;
+  }
+  e->last_use = ++use_clock;
+  return e->power;
+}
+/*---------------------------------------------------------------------------*/
+void
+txpower_adapt_update(const uint8_t *addr, bool is_short, bool acked, int8_t ack_rssi)
+{
+  txpower_entry_t *e = lookup_or_add(addr, is_short);
+  int8_t old = e->power;
+  /* our power minus the path loss seen on the ACK */
+  int est = e->power - (power_default - ack_rssi);
+
+  e->last_use = ++use_clock;
+  if(!acked) {
+    e->strong = 0;
+    if(++e->missed >= TXPOWER_ADAPT_RAISE_AFTER) {
+      e->missed = 0;
+      e->power = clamp(e->power + 2 * TXPOWER_ADAPT_STEP);
+    }
+  } else {
+    e->missed = 0;
+    if(est < TXPOWER_ADAPT_TARGET_RSSI) {
+      e->strong = 0;
+      e->power = clamp(e->power + TXPOWER_ADAPT_STEP);
+    } else if(est >= TXPOWER_ADAPT_TARGET_RSSI + TXPOWER_ADAPT_MARGIN) {
+      if(++e->strong >= TXPOWER_ADAPT_LOWER_AFTER) {
+        e->strong = 0;
+        e->power = clamp(e->power - TXPOWER_ADAPT_STEP);
+      }
+    } else {
+      e->strong = 0;           /* healthy, but no room to lower */
+    }
+  }
+  if(e->power < old) {
+    stats.lowered++;
+  } else if(e->power > old) {
+    stats.raised++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+txpower_adapt_get_stats(txpower_adapt_stats_t *s)
+{
+  *s = stats;
+}
@@ -0,0 +1,58 @@
+/* txpower-adapt.h - per-neighbour TX power adaptation from ACK feedback
+ *
+ * Each unicast destination gets its own output power, starting at the
+ * default. Hardware ACKs go out at the default power, so the ACK RSSI gives
+ * the path loss. Links are assumed roughly symmetric, and the RSSI our frame
+ * arrives with is estimated from that. While the estimate stays well above
+ * the target, the power steps down after a run of such ACKs. A weak
+ * estimate steps it up. Missed ACKs step it up twice as far, but only a
+ * run of them: a single miss is as likely a collision or a lost ACK, and
+ * ACKs go out at the default power whatever ours is.
+ *
+ * The module has no ESP-IDF or Contiki dependency and can be driven from a
+ * simulated link on a host. Addresses are keys only; any byte order works.
+ */
+#ifndef TXPOWER_ADAPT_H_
+#define TXPOWER_ADAPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TXPOWER_ADAPT_NEIGHBORS
+#define TXPOWER_ADAPT_NEIGHBORS    16
+#endif
+#ifndef TXPOWER_ADAPT_TARGET_RSSI
+#define TXPOWER_ADAPT_TARGET_RSSI  -85   /* dBm, weakest ACK still considered healthy */
+#endif
+#ifndef TXPOWER_ADAPT_MARGIN
+#define TXPOWER_ADAPT_MARGIN       6     /* dB above target before lowering power */
+#endif
+#ifndef TXPOWER_ADAPT_STEP
+#define TXPOWER_ADAPT_STEP         3     /* dB */
+#endif
+#ifndef TXPOWER_ADAPT_LOWER_AFTER
+#define TXPOWER_ADAPT_LOWER_AFTER  4     /* strong ACKs in a row before stepping down */
+#endif
+#ifndef TXPOWER_ADAPT_RAISE_AFTER
+#define TXPOWER_ADAPT_RAISE_AFTER  2     /* missed ACKs in a row before stepping up */
+#endif
+
+typedef struct {
+  uint32_t lowered;
+  uint32_t raised;
+  uint32_t evictions;       /* neighbours forgotten because the table was full */
+} txpower_adapt_stats_t;
+
+/* Range the power is kept in, and the power for unknown neighbours */
+void txpower_adapt_init(int8_t min_dbm, int8_t max_dbm, int8_t default_dbm);
+void txpower_adapt_set_default(int8_t default_dbm);
+
+/* Power to use for a frame to addr (2 bytes when is_short, else 8) */
+int8_t txpower_adapt_get(const uint8_t *addr, bool is_short);
+
+/* Feed back the result of a frame sent to addr; ack_rssi is ignored unless acked */
+void txpower_adapt_update(const uint8_t *addr, bool is_short, bool acked, int8_t ack_rssi);
+
+void txpower_adapt_get_stats(txpower_adapt_stats_t *stats);
+
+#endif /* TXPOWER_ADAPT_H_ */
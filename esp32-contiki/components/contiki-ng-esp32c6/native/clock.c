@@ -0,0 +1,29 @@
+#include "contiki.h"
+#include "rtimer-arch.h"
+
+static uint64_t boot_us;
+
+void clock_init(void)
+{
+  boot_us = rtimer_arch_now();
+}
+
+clock_time_t clock_time(void)                /* tick = 1 ms */
+{
+  return (clock_time_t)((rtimer_arch_now() - boot_us) / 1000);
+}
+
+unsigned long clock_seconds(void)
+{
+  return (unsigned long)((rtimer_arch_now() - boot_us) / 1000000ULL);
+}
+
+void clock_delay_usec(uint16_t dt) {         /* busy-wait */
+  uint64_t target = rtimer_arch_now() + dt;
+  while(rtimer_arch_now() < target) ;
+}
+
+uint64_t clock_arch_time_to_us(clock_time_t t)
+{
+  return boot_us + (uint64_t)t * 1000;
+}
@@ -0,0 +1,47 @@
+/* native/contiki-conf.h - the ESP32-C6 port's configuration for Linux nodes */
+#ifndef CONTIKI_CONF_H_
+#define CONTIKI_CONF_H_
+
+#include <stdint.h>
+
+/* ------------------------------------------------------------------ */
+/*  CPU / compiler specifics                                          */
+/* ------------------------------------------------------------------ */
+#define CC_CONF_REGISTER_ARGS         1
+#define CC_CONF_FUNCTION_POINTER_ARGS 1
+#define CC_CONF_VA_ARGS               1
+#define CC_CONF_INLINE                inline
+#define CC_CONF_ALIGN_PACK(n)         __attribute__((packed,aligned(n)))
+
+/* ---------- CLOCKS ------------------------------------------------ */
+#define CLOCK_CONF_SECOND            1000          /* 1 ms ticks from clock.c */
+
+/* ---------- REAL-TIME TIMER -------------------------------------- */
+/* Same 64-bit 1 MHz timebase as on the device */
+#define RTIMER_CONF_CLOCK_TYPE       uint64_t
+#define RTIMER_CONF_SECOND           1000000UL
+#define RTIMER_CONF_ARCH_NOW          rtimer_arch_now
+
+#define CONTIKI_VERSION_STRING "Contiki-NG-ESP32C6"
+#define CONTIKI_TARGET_STRING "esp32c6-native"
+
+/* Network stack configuration, as on the device */
+#define UIP_CONF_IPV6 1
+#define RPL_CONF_ENABLED        1
+#define NETSTACK_CONF_WITH_IPV6 1
+#define ROUTING_CONF_RPL_LITE   1
+#define NETSTACK_CONF_MAC       csma_driver
+#define NETSTACK_CONF_FRAMER    framer_802154
+#define NETSTACK_CONF_RADIO     native_radio_driver
+
+#define LEDS_CONF_COUNT  1
+
+#define UIP_CONF_STATISTICS 1
+typedef uint32_t uip_stats_t;
+
+/* Application overrides come last */
+#ifdef PROJECT_CONF_H
+#include PROJECT_CONF_H
+#endif
+
+#endif /* CONTIKI_CONF_H_ */
@@ -0,0 +1,168 @@
+/* native/contiki-main.c - run the port's network stack as a Linux process
+ *
+ *   node-client -n <id> [-m medium path] [-s seed] [-c] [-a]
+ *
+ * Same start-up as platform/contiki-main.c, with the link address derived
+ * from the node id and the medium socket added to the wait in the loop.
+ * -c sends on CCA (RADIO_TX_MODE_SEND_ON_CCA), -a adapts the TX power per
+ * neighbour (native_radio_txpower_adapt()). SIGINT or SIGTERM stop the
+ * node, which prints its radio counters on the way out.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include "contiki.h"
+#include "contiki-net.h"
+#include "dev/watchdog.h"
+#include "lib/random.h"
+#include "net/linkaddr.h"
+#include "net/net-debug.h"
+#include "radio-native.h"
+#include "sim-medium.h"
+
+/*---------------------------------------------------------------------------*/
+/* Log configuration */
+#include "sys/log.h"
+#define LOG_MODULE "Main"
+#define LOG_LEVEL LOG_LEVEL_MAIN
+/*---------------------------------------------------------------------------*/
+
+#define MAX_SLEEP_MS 1000
+
+/* clock.c */
+uint64_t clock_arch_time_to_us(clock_time_t t);
+
+static volatile sig_atomic_t stop;
+/*---------------------------------------------------------------------------*/
+/* Block until the medium has a message, or the next etimer or rtimer is due */
+static void
+native_sleep(void)
+{
+  uint64_t now = rtimer_arch_now();
+  uint64_t wake = now + MAX_SLEEP_MS * 1000ULL;
+  struct pollfd p = { .fd = native_radio_fd(), .events = POLLIN };
+
+  if(etimer_pending()) {
+    uint64_t t = clock_arch_time_to_us(etimer_next_expiration_time());
+    if(t < wake) {
+      wake = t;
+    }
+  }
+  if(rtimer_arch_next() != 0 && rtimer_arch_next() < wake) {
+    wake = rtimer_arch_next();
+  }
+  if(wake <= now) {
+    return;
+  }
+  /* round up, an early wake-up would only come back here */
+  if(poll(&p, 1, (wake - now + 999) / 1000) > 0) {
+    native_radio_input();
+  }
+}
+static void
+on_signal(int sig)
+{
+  (void)sig;
+  stop = 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_radio_stats(void)
+{
+  native_radio_stats_t s;
+
+  native_radio_get_stats(&s);
+  printf("radio: %lu transmissions, %lu repeated, %lu cca checks, %lu busy,"
+         " %lu on air, %lu no ack, %ld dBm total, %.1f uJ radiated\n",
+         s.transmissions, s.repeated, s.cca_checks, s.cca_busy,
+         s.on_air, s.noack, s.txpower_sum, s.radiated_uj);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  uint16_t id = 1;
+  const char *medium = NULL;
+  unsigned seed = 0;
+  bool send_on_cca = false;
+  bool adapt = false;
+  uint8_t addr[8];
+  struct sigaction sa = { .sa_handler = on_signal };
+  int opt;
+
+  while((opt = getopt(argc, argv, "n:m:s:ca")) != -1) {
+    switch(opt) {
+    case 'n': id = atoi(optarg); break;
+    case 'm': medium = optarg; break;
+    case 's': seed = atoi(optarg); break;
+    case 'c': send_on_cca = true; break;
+    case 'a': adapt = true; break;
+    default:
+      fprintf(stderr, "usage: %s -n id [-m medium path] [-s seed] [-c] [-a]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(id == 0 || id >= SIM_MAX_NODES) {
+    fprintf(stderr, "%s: node id must be 1..%u\n", argv[0], SIM_MAX_NODES - 1);
+    return 1;
+  }
+  /* log lines are timestamped by whoever reads them */
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  clock_init();
+  rtimer_arch_init();
+  random_init(seed ? seed : id);
+
+  process_init();
+  process_start(&etimer_process, NULL);
+  ctimer_init();
+  watchdog_init();
+
+  sim_node_addr(id, addr);
+  linkaddr_set_node_addr((linkaddr_t *)addr);
+  LOG_INFO("Node %u, MAC address: [", id);
+  net_debug_lladdr_print((const uip_lladdr_t *)addr);
+  LOG_INFO_("]\n");
+
+  native_radio_config(id, medium);
+  native_radio_txpower_adapt(adapt);
+  netstack_init();
+  if(send_on_cca) {
+    NETSTACK_RADIO.set_value(RADIO_PARAM_TX_MODE, RADIO_TX_MODE_SEND_ON_CCA);
+  }
+
+  LOG_INFO("Starting " CONTIKI_VERSION_STRING "\n");
+  LOG_INFO("- Routing: %s\n", NETSTACK_ROUTING.name);
+  LOG_INFO("- Net: %s\n", NETSTACK_NETWORK.name);
+  LOG_INFO("- MAC: %s\n", NETSTACK_MAC.name);
+
+#if NETSTACK_CONF_WITH_IPV6
+  memcpy(&uip_lladdr.addr, &linkaddr_node_addr, sizeof(uip_lladdr.addr));
+  process_start(&tcpip_process, NULL);
+#endif /* NETSTACK_CONF_WITH_IPV6 */
+
+  autostart_start(autostart_processes);
+
+  watchdog_start();
+  while(!stop) {
+    rtimer_arch_run_due();
+
+    /* drive the e-timer engine once the first software timer is due */
+    if(etimer_pending() && !CLOCK_LT(clock_time(), etimer_next_expiration_time())) {
+      etimer_request_poll();
+    }
+
+    /* run all pending events until none are left */
+    while(process_run()) ;
+
+    watchdog_periodic();
+    native_sleep();
+  }
+  print_radio_stats();
+  return 0;
+}
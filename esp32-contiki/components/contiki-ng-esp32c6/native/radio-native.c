@@ -0,0 +1,452 @@
+/* radio-native.c - Contiki radio driver for native nodes on sim-medium */
+#include "contiki.h"
+#include "dev/radio.h"
+#include "net/packetbuf.h"
+#include "net/netstack.h"
+#include "net/mac/framer/frame802154.h"
+#include "radio-native.h"
+#include "sim-medium.h"
+#include "txpower-adapt.h"
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define RX_QUEUE_SIZE  8
+#define CCA_THRESHOLD_DEFAULT  -75   /* dBm, RADIO_PARAM_CCA_THRESHOLD */
+
+/* Output power range of the ESP32-C6 802.15.4 PHY, as in radio-esp32c6.c */
+#define TXPOWER_MIN  -24
+#define TXPOWER_MAX  20
+
+typedef struct {
+  uint8_t buf[SIM_MAX_FRAME];
+  uint8_t len;
+  int8_t rssi;
+  uint8_t lqi;
+} rx_frame_t;
+
+static rx_frame_t rx_queue[RX_QUEUE_SIZE];
+static unsigned rx_head, rx_tail;        /* one thread, no locking */
+static uint32_t rx_overflows;
+
+static uint16_t sim_id;                  /* not Contiki's node_id, sys/node-id.h */
+static const char *medium_path = SIM_MEDIUM_DEFAULT_PATH;
+static int sock = -1;
+static struct sockaddr_un medium;
+
+static bool radio_on;
+static uint8_t channel = IEEE802154_DEFAULT_CHANNEL;
+static uint16_t pan_id = IEEE802154_PANID;
+static uint16_t short_addr;
+static radio_value_t rx_mode = RADIO_RX_MODE_ADDRESS_FILTER | RADIO_RX_MODE_AUTOACK;
+static radio_value_t tx_mode;            /* RADIO_TX_MODE_* flags */
+static int8_t cca_threshold = CCA_THRESHOLD_DEFAULT;
+static int8_t txpower_default;           /* RADIO_PARAM_TXPOWER, also our ACKs */
+static int8_t txpower;                   /* of the frame being sent */
+static bool txpower_adapt;               /* native_radio_txpower_adapt() */
+static int8_t last_rssi;
+static uint8_t last_lqi;
+
+static uint8_t tx_buf[SIM_MAX_FRAME];
+static uint16_t tx_len;
+static uint8_t last_tx[SIM_MAX_FRAME];   /* to spot CSMA's retransmissions */
+static uint16_t last_tx_len;
+
+static native_radio_stats_t stats;
+
+PROCESS(native_radio_process, "native radio");
+/*---------------------------------------------------------------------------*/
+static int
+medium_send(uint8_t type, const uint8_t *frame, uint16_t len)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+  sim_msg_hdr_t h = { .type = type, .channel = channel, .node = sim_id, .len = len,
+                      .rssi = cca_threshold, .txpower = txpower };
+
+  memcpy(buf, &h, sizeof(h));
+  memcpy(buf + sizeof(h), frame, len);
+  return sendto(sock, buf, sizeof(h) + len, 0, (struct sockaddr *)&medium, sizeof(medium));
+}
+/*---------------------------------------------------------------------------*/
+/* One message from the medium. Returns its type, 0 if there was none. */
+static int
+medium_receive(uint8_t *status)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+  sim_msg_hdr_t h;
+  ssize_t n = recv(sock, buf, sizeof(buf), MSG_DONTWAIT);
+
+  if(n < (ssize_t)sizeof(h)) {
+    return 0;
+  }
+  memcpy(&h, buf, sizeof(h));
+  if(h.type == SIM_MSG_TX_DONE || h.type == SIM_MSG_CCA_DONE) {
+    *status = h.status;
+  } else if(h.type == SIM_MSG_RX && radio_on && h.len <= n - sizeof(h)) {
+    if(rx_head - rx_tail >= RX_QUEUE_SIZE) {
+      rx_overflows++;
+    } else {
+      rx_frame_t *f = &rx_queue[rx_head++ % RX_QUEUE_SIZE];
+      memcpy(f->buf, buf + sizeof(h), h.len);
+      f->len = h.len;
+      f->rssi = h.rssi;
+      f->lqi = h.lqi;
+      process_poll(&native_radio_process);
+    }
+  }
+  return h.type;
+}
+/*---------------------------------------------------------------------------*/
+/* Send a request and process what the medium sends until its answer, at
+   most timeout_ms. Returns the answer's status, or fail. */
+static uint8_t
+medium_request(uint8_t type, const uint8_t *frame, uint16_t len, uint8_t answer,
+               int timeout_ms, uint8_t fail)
+{
+  uint8_t status = fail;
+  struct pollfd p = { .fd = sock, .events = POLLIN };
+
+  if(medium_send(type, frame, len) < 0) {
+    return fail;
+  }
+  while(poll(&p, 1, timeout_ms) > 0) {
+    if(medium_receive(&status) == answer) {
+      return status;
+    }
+  }
+  return fail;
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  struct sockaddr_un self = { .sun_family = AF_UNIX };
+
+  medium.sun_family = AF_UNIX;
+  strncpy(medium.sun_path, medium_path, sizeof(medium.sun_path) - 1);
+  snprintf(self.sun_path, sizeof(self.sun_path), "%s.%u", medium_path, sim_id);
+  unlink(self.sun_path);
+  sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if(sock < 0 || bind(sock, (struct sockaddr *)&self, sizeof(self)) < 0) {
+    perror(self.sun_path);
+    return 1;
+  }
+  radio_on = true;
+  txpower = txpower_default;
+  txpower_adapt_init(TXPOWER_MIN, TXPOWER_MAX, txpower_default);
+  medium_send(SIM_MSG_HELLO, NULL, 0);
+  process_start(&native_radio_process, NULL);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+prepare(const void *payload, unsigned short len)
+{
+  if(len > sizeof(tx_buf)) {
+    return RADIO_TX_ERR;
+  }
+  memcpy(tx_buf, payload, len);
+  tx_len = len;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Destination of a unicast that asks for an ACK, in Contiki byte order */
+static bool
+tx_unicast_dest(const uint8_t *frame, unsigned short len, uint8_t *addr, bool *is_short)
+{
+  frame802154_t f;
+
+  if(frame802154_parse((uint8_t *)frame, len, &f) <= 0 || !f.fcf.ack_required) {
+    return false;
+  }
+  if(f.fcf.dest_addr_mode == FRAME802154_SHORTADDRMODE) {
+    *is_short = true;
+  } else if(f.fcf.dest_addr_mode == FRAME802154_LONGADDRMODE) {
+    *is_short = false;
+  } else {
+    return false;
+  }
+  memcpy(addr, f.dest_addr, *is_short ? 2 : 8);
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* The ACK for seqno among the frames queued since head, and its RSSI */
+static bool
+find_ack(unsigned head, uint8_t seqno, int8_t *rssi)
+{
+  for(; head != rx_head; head++) {
+    const rx_frame_t *f = &rx_queue[head % RX_QUEUE_SIZE];
+
+    if(f->len == 3 && (f->buf[0] & 7) == FRAME802154_ACKFRAME && f->buf[2] == seqno) {
+      *rssi = f->rssi;
+      return true;
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+static int channel_clear(void);
+
+/* Blocks until the medium has delivered the frame at the end of its
+   airtime. An ACK arrives as a received frame, as it would from the air.
+   With SEND_ON_CCA a busy channel is a collision, as on the device. With
+   adaptation on, a unicast goes out at its neighbour's power and the ACK
+   feeds back into txpower-adapt.c. */
+static int
+transmit(unsigned short len)
+{
+  uint8_t dest[8];
+  bool dest_short = false;
+  bool unicast = tx_unicast_dest(tx_buf, len, dest, &dest_short);
+  int8_t ack_rssi = 0;
+  unsigned head;
+  uint8_t status;
+  int ret = RADIO_TX_ERR;
+
+  if(len == last_tx_len && memcmp(tx_buf, last_tx, len) == 0) {
+    stats.repeated++;
+  }
+  memcpy(last_tx, tx_buf, len);
+  last_tx_len = len;
+  stats.transmissions++;
+  if((tx_mode & RADIO_TX_MODE_SEND_ON_CCA) && !channel_clear()) {
+    return RADIO_TX_COLLISION;
+  }
+  if(txpower_adapt && unicast) {
+    txpower = txpower_adapt_get(dest, dest_short);
+  }
+  head = rx_head;
+  status = medium_request(SIM_MSG_TX, tx_buf, len, SIM_MSG_TX_DONE, 1000, SIM_TX_ERR);
+  if(status == SIM_TX_OK) {
+    ret = RADIO_TX_OK;
+    stats.on_air++;
+    stats.txpower_sum += txpower;
+    /* mW for the airtime in us gives nJ */
+    stats.radiated_uj += pow(10.0, txpower / 10.0) * SIM_AIRTIME_US(len) / 1000.0;
+    if(unicast) {
+      bool acked = find_ack(head, tx_buf[2], &ack_rssi);
+
+      if(!acked) {
+        stats.noack++;
+        ret = RADIO_TX_NOACK;      /* CSMA retries it */
+      }
+      if(txpower_adapt) {
+        txpower_adapt_update(dest, dest_short, acked, ack_rssi);
+      }
+    }
+  }
+  txpower = txpower_default;
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_send(const void *payload, unsigned short len)
+{
+  prepare(payload, len);
+  return transmit(len);
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_read(void *buf, unsigned short size)
+{
+  rx_frame_t *f;
+  int len;
+
+  if(rx_head == rx_tail) {
+    return 0;
+  }
+  f = &rx_queue[rx_tail++ % RX_QUEUE_SIZE];
+  len = f->len <= size ? f->len : 0;
+  memcpy(buf, f->buf, len);
+  last_rssi = f->rssi;
+  last_lqi = f->lqi;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+/* The medium knows what is on the air; no answer leaves the channel clear */
+static int
+channel_clear(void)
+{
+  stats.cca_checks++;
+  if(medium_request(SIM_MSG_CCA, NULL, 0, SIM_MSG_CCA_DONE, 100,
+                    SIM_CCA_CLEAR) == SIM_CCA_BUSY) {
+    stats.cca_busy++;
+    return 0;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int
+receiving_packet(void)
+{
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+pending_packet(void)
+{
+  uint8_t status;
+
+  while(medium_receive(&status) != 0) ;
+  return rx_head != rx_tail;
+}
+/*---------------------------------------------------------------------------*/
+static int
+on(void)
+{
+  radio_on = true;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static int
+off(void)
+{
+  radio_on = false;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_value(radio_param_t param, radio_value_t *v)
+{
+  switch(param) {
+  case RADIO_PARAM_POWER_MODE:
+    *v = radio_on ? RADIO_POWER_MODE_ON : RADIO_POWER_MODE_OFF;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CHANNEL: *v = channel; return RADIO_RESULT_OK;
+  case RADIO_PARAM_PAN_ID: *v = pan_id; return RADIO_RESULT_OK;
+  case RADIO_PARAM_16BIT_ADDR: *v = short_addr; return RADIO_RESULT_OK;
+  case RADIO_PARAM_RX_MODE: *v = rx_mode; return RADIO_RESULT_OK;
+  case RADIO_PARAM_TX_MODE: *v = tx_mode; return RADIO_RESULT_OK;
+  case RADIO_PARAM_CCA_THRESHOLD: *v = cca_threshold; return RADIO_RESULT_OK;
+  case RADIO_PARAM_TXPOWER: *v = txpower_default; return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_RSSI: *v = last_rssi; return RADIO_RESULT_OK;
+  case RADIO_PARAM_LAST_LINK_QUALITY: *v = last_lqi; return RADIO_RESULT_OK;
+  case RADIO_CONST_CHANNEL_MIN: *v = 11; return RADIO_RESULT_OK;
+  case RADIO_CONST_CHANNEL_MAX: *v = 26; return RADIO_RESULT_OK;
+  case RADIO_CONST_MAX_PAYLOAD_LEN: *v = SIM_MAX_FRAME - 2; return RADIO_RESULT_OK;
+  case RADIO_CONST_TXPOWER_MIN: *v = TXPOWER_MIN; return RADIO_RESULT_OK;
+  case RADIO_CONST_TXPOWER_MAX: *v = TXPOWER_MAX; return RADIO_RESULT_OK;
+  default: return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_value(radio_param_t param, radio_value_t v)
+{
+  switch(param) {
+  case RADIO_PARAM_POWER_MODE:
+    return v == RADIO_POWER_MODE_ON ? (on(), RADIO_RESULT_OK) :
+           v == RADIO_POWER_MODE_OFF ? (off(), RADIO_RESULT_OK) : RADIO_RESULT_INVALID_VALUE;
+  case RADIO_PARAM_CHANNEL:
+    if(v < 11 || v > 26) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    channel = v;
+    medium_send(SIM_MSG_HELLO, NULL, 0);   /* the medium delivers per channel */
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_PAN_ID: pan_id = v; return RADIO_RESULT_OK;
+  case RADIO_PARAM_16BIT_ADDR: short_addr = v; return RADIO_RESULT_OK;
+  case RADIO_PARAM_RX_MODE: rx_mode = v; return RADIO_RESULT_OK;
+  case RADIO_PARAM_TX_MODE:
+    if(v & ~RADIO_TX_MODE_SEND_ON_CCA) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    tx_mode = v;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_CCA_THRESHOLD:
+    if(v < INT8_MIN || v > INT8_MAX) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    cca_threshold = v;
+    return RADIO_RESULT_OK;
+  case RADIO_PARAM_TXPOWER:
+    if(v < TXPOWER_MIN || v > TXPOWER_MAX) {
+      return RADIO_RESULT_INVALID_VALUE;
+    }
+    txpower_default = txpower = v;
+    txpower_adapt_set_default(v);
+    medium_send(SIM_MSG_HELLO, NULL, 0);   /* the power of our ACKs */
+    return RADIO_RESULT_OK;
+  default: return RADIO_RESULT_NOT_SUPPORTED;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+get_object(radio_param_t param, void *dest, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+static radio_result_t
+set_object(radio_param_t param, const void *src, size_t size)
+{
+  return RADIO_RESULT_NOT_SUPPORTED;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(native_radio_process, ev, data)
+{
+  int len;
+
+  PROCESS_BEGIN();
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    while(rx_head != rx_tail) {
+      packetbuf_clear();
+      len = radio_read(packetbuf_dataptr(), PACKETBUF_SIZE);
+      if(len > 0) {
+        packetbuf_set_datalen(len);
+        packetbuf_set_attr(PACKETBUF_ATTR_RSSI, last_rssi);
+        packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, last_lqi);
+        NETSTACK_MAC.input();
+      }
+    }
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+void
+native_radio_config(uint16_t id, const char *path)
+{
+  sim_id = id;
+  if(path != NULL) {
+    medium_path = path;
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+native_radio_fd(void)
+{
+  return sock;
+}
+/*---------------------------------------------------------------------------*/
+void
+native_radio_input(void)
+{
+  uint8_t status;
+
+  while(medium_receive(&status) != 0) ;
+}
+/*---------------------------------------------------------------------------*/
+void
+native_radio_txpower_adapt(bool on)
+{
+  txpower_adapt = on;
+}
+/*---------------------------------------------------------------------------*/
+void
+native_radio_get_stats(native_radio_stats_t *s)
+{
+  *s = stats;
+}
+/*---------------------------------------------------------------------------*/
+
+const struct radio_driver native_radio_driver = {
+  init, prepare, transmit, radio_send, radio_read,
+  channel_clear, receiving_packet, pending_packet,
+  on, off, get_value, set_value, get_object, set_object
+};
@@ -0,0 +1,33 @@
+/* radio-native.h - 802.15.4 radio on the simulated medium (sim-medium.h) */
+#ifndef RADIO_NATIVE_H_
+#define RADIO_NATIVE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "dev/radio.h"
+
+extern const struct radio_driver native_radio_driver;
+
+typedef struct {
+  unsigned long transmissions;   /* transmit() calls */
+  unsigned long repeated;        /* same frame as the one before, CSMA retries */
+  unsigned long cca_checks;
+  unsigned long cca_busy;
+  unsigned long on_air;          /* frames the medium took */
+  unsigned long noack;           /* of those, unicasts without an ACK */
+  long txpower_sum;              /* dBm over on_air */
+  double radiated_uj;            /* TX power times airtime */
+} native_radio_stats_t;
+
+/* Before netstack_init(): this node's id and the medium's socket path */
+void native_radio_config(uint16_t node_id, const char *medium_path);
+/* Socket to wait on in the main loop, and what to call when it is readable */
+int native_radio_fd(void);
+void native_radio_input(void);
+
+/* Per-neighbour TX power from ACK feedback, see txpower-adapt.h */
+void native_radio_txpower_adapt(bool on);
+
+void native_radio_get_stats(native_radio_stats_t *stats);
+
+#endif /* RADIO_NATIVE_H_ */
@@ -0,0 +1,42 @@
+/* native/rtimer-arch.c - rtimers fired from the main loop
+ *
+ * The main loop sleeps in poll() until the next alarm at the latest and
+ * then calls rtimer_arch_run_due(). Callbacks thus run between Contiki
+ * events rather than preempting them, as with the esp_timer backend.
+ */
+#include "contiki.h"
+#include "rtimer-arch.h"
+#include <time.h>
+
+static rtimer_clock_t next_alarm;
+
+void rtimer_arch_init(void)
+{
+  next_alarm = 0;
+}
+
+rtimer_clock_t rtimer_arch_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (rtimer_clock_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void rtimer_arch_schedule(rtimer_clock_t t)
+{
+  next_alarm = t > 0 ? t : 1;
+}
+
+rtimer_clock_t rtimer_arch_next(void)
+{
+  return next_alarm;
+}
+
+void rtimer_arch_run_due(void)
+{
+  if(next_alarm != 0 && rtimer_arch_now() >= next_alarm) {
+    next_alarm = 0;
+    rtimer_run_next();         /* may schedule the next one */
+  }
+}
@@ -0,0 +1,464 @@
+/* sim-medium.c - simulated IEEE 802.15.4 medium for native nodes
+ *
+ * Reads node positions from a topology file ("<id> <x> <y>" per line, in
+ * metres) and relays frames between the nodes (see sim-medium.h). The
+ * received power follows a log-distance path loss model from the TX power
+ * the node gave for the frame. Each reception succeeds with a probability
+ * that rises from 0 to 1 around the receiver sensitivity, times 1 - the
+ * extra loss given with -l. ACKs go through the same model in the other
+ * direction, at the power the receiver announced.
+ *
+ * Frames stay on the air for their airtime and are delivered when it ends.
+ * A receiver loses a frame to a collision if it was transmitting itself
+ * meanwhile, or heard an overlapping frame on the channel less than
+ * CAPTURE_DB weaker. Interference below the sensitivity does not add up,
+ * and ACKs take no airtime. CCA reports busy while a frame from another
+ * node is on the air at or above the node's threshold.
+ *
+ *   sim-medium -t topo.txt [-m path] [-l loss] [-s seed] [-e exponent]
+ *              [-r sensitivity]
+ *
+ * Totals are printed on SIGINT/SIGTERM.
+ */
+#define _GNU_SOURCE            /* ppoll() */
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim-medium.h"
+
+#define PL0_DB         40.0    /* path loss at 1 m, 2.4 GHz */
+#define PRR_SLOPE_DB   1.5     /* width of the reception probability curve */
+#define LQI_RANGE_DB   60.0    /* LQI 255 this far above the sensitivity */
+#define CAPTURE_DB     3.0     /* a frame survives interference this much weaker */
+#define AIR_SLOTS      64      /* frames on the air or recently ended */
+#define AIR_KEEP_US    SIM_AIRTIME_US(SIM_MAX_FRAME)
+
+typedef struct {
+  bool placed;                 /* listed in the topology */
+  bool registered;             /* sent HELLO */
+  double x, y;
+  uint8_t channel;
+  int8_t txpower;              /* dBm, its ACKs */
+  struct sockaddr_un addr;
+  socklen_t addr_len;
+} sim_node_t;
+
+/* A frame from TX until no frame on the air can still overlap it */
+typedef struct {
+  bool used;
+  bool ended;                  /* delivered, kept as interference */
+  uint16_t src;
+  uint8_t channel;
+  int8_t txpower;
+  uint64_t start, end;         /* us, CLOCK_MONOTONIC */
+  uint16_t len;
+  uint8_t frame[SIM_MAX_FRAME];
+} air_frame_t;
+
+static sim_node_t nodes[SIM_MAX_NODES];
+static air_frame_t air[AIR_SLOTS];
+static double path_loss_exp = 3.0;
+static double sensitivity_dbm = -94.0;
+static double extra_loss;
+
+static struct {
+  unsigned long tx, unicast, rx, lost, collisions, out_of_range, acks, ack_lost, overruns;
+  unsigned long cca, cca_busy;
+} totals;
+static volatile sig_atomic_t stop;
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static double
+rssi_between(const sim_node_t *a, const sim_node_t *b, int8_t txpower)
+{
+  double d = hypot(a->x - b->x, a->y - b->y);
+
+  if(d < 1.0) {
+    d = 1.0;
+  }
+  return txpower - PL0_DB - 10.0 * path_loss_exp * log10(d);
+}
+/*---------------------------------------------------------------------------*/
+static bool
+received(double rssi)
+{
+  double prr = 1.0 / (1.0 + exp(-(rssi - sensitivity_dbm - 3.0) / PRR_SLOPE_DB));
+
+  return drand48() < prr * (1.0 - extra_loss);
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+lqi_of(double rssi)
+{
+  double q = (rssi - sensitivity_dbm) * 255.0 / LQI_RANGE_DB;
+
+  return q < 0 ? 0 : q > 255 ? 255 : (uint8_t)q;
+}
+/*---------------------------------------------------------------------------*/
+/* Destination node of a unicast frame asking for an ACK, -1 otherwise */
+static int
+ack_dest(const uint8_t *f, unsigned len)
+{
+  uint16_t fcf;
+  unsigned dst_mode;
+
+  if(len < 3) {
+    return -1;
+  }
+  fcf = f[0] | f[1] << 8;
+  dst_mode = (fcf >> 10) & 3;
+  if(!(fcf & (1 << 5)) || dst_mode != 3 || len < 3 + 2 + 8) {
+    return -1;
+  }
+  /* seqno, PAN ID, then the address, least significant byte first */
+  {
+    const uint8_t *a = f + 5;
+    uint8_t mine[8];
+    uint16_t id = a[0] | a[1] << 8;
+
+    if(id >= SIM_MAX_NODES) {
+      return -1;
+    }
+    sim_node_addr(id, mine);
+    for(int i = 0; i < 8; i++) {
+      if(a[i] != mine[7 - i]) {
+        return -1;
+      }
+    }
+    return id;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static bool
+send_to(int fd, const sim_node_t *n, const sim_msg_hdr_t *h, const uint8_t *frame)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+
+  memcpy(buf, h, sizeof(*h));
+  if(h->len > 0) {
+    memcpy(buf + sizeof(*h), frame, h->len);
+  }
+  /* never wait for a node that is not reading, count the loss instead */
+  if(sendto(fd, buf, sizeof(*h) + h->len, MSG_DONTWAIT,
+            (const struct sockaddr *)&n->addr, n->addr_len) < 0) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      totals.overruns++;
+    } else if(errno != ECONNREFUSED && errno != ENOENT) {
+      perror("sendto");
+    }
+    return false;
+  }
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Whether receiver r lost f, heard at rssi, to another frame overlapping it */
+static bool
+collided(const air_frame_t *f, int r, double rssi)
+{
+  for(int i = 0; i < AIR_SLOTS; i++) {
+    const air_frame_t *g = &air[i];
+
+    if(!g->used || g == f || g->channel != f->channel ||
+       g->end <= f->start || f->end <= g->start) {
+      continue;
+    }
+    if(g->src == r ||
+       rssi_between(&nodes[g->src], &nodes[r], g->txpower) > rssi - CAPTURE_DB) {
+      return true;
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+/* The end of f's airtime: deliver it, then the ACK and TX_DONE to the sender */
+static void
+deliver(int fd, air_frame_t *f)
+{
+  sim_node_t *s = &nodes[f->src];
+  sim_msg_hdr_t h = { .type = SIM_MSG_RX, .channel = f->channel, .node = f->src,
+                      .len = f->len };
+  sim_msg_hdr_t done = { .type = SIM_MSG_TX_DONE, .node = f->src, .status = SIM_TX_OK };
+  const uint8_t *frame = f->frame;
+  int dest = ack_dest(frame, f->len);
+  bool acked = false;
+
+  totals.tx++;
+  if(dest >= 0) {
+    totals.unicast++;
+  }
+  for(int i = 0; i < SIM_MAX_NODES; i++) {
+    sim_node_t *r = &nodes[i];
+    double rssi;
+
+    if(i == f->src || !r->registered || !r->placed || r->channel != f->channel) {
+      continue;
+    }
+    rssi = rssi_between(s, r, f->txpower);
+    if(rssi < sensitivity_dbm - 10) {
+      totals.out_of_range++;
+      continue;
+    }
+    if(collided(f, i, rssi)) {
+      totals.collisions++;
+      continue;
+    }
+    if(!received(rssi)) {
+      totals.lost++;
+      continue;
+    }
+    h.rssi = (int8_t)lround(rssi);
+    h.lqi = lqi_of(rssi);
+    if(!send_to(fd, r, &h, frame)) {
+      continue;
+    }
+    totals.rx++;
+    if(i == dest) {
+      /* the ACK takes the same path back, at the receiver's power */
+      if(received(rssi_between(r, s, r->txpower))) {
+        acked = true;
+      } else {
+        totals.ack_lost++;
+      }
+    }
+  }
+  if(acked) {
+    uint8_t ack[3] = { 0x02, 0x00, frame[2] };
+    sim_msg_hdr_t a = { .type = SIM_MSG_RX, .channel = f->channel, .node = dest,
+                        .len = sizeof(ack) };
+    double rssi = rssi_between(&nodes[dest], s, nodes[dest].txpower);
+
+    a.rssi = (int8_t)lround(rssi);
+    a.lqi = lqi_of(rssi);
+    send_to(fd, s, &a, ack);
+    totals.acks++;
+  }
+  send_to(fd, s, &done, NULL);
+  f->ended = true;
+}
+/*---------------------------------------------------------------------------*/
+/* Put a frame on the air. False if too many frames are on it already. */
+static bool
+transmit(uint16_t src, uint8_t channel, int8_t txpower, const uint8_t *frame, unsigned len)
+{
+  uint64_t now = now_us();
+
+  for(int i = 0; i < AIR_SLOTS; i++) {
+    air_frame_t *f = &air[i];
+
+    if(!f->used) {
+      f->used = true;
+      f->ended = false;
+      f->src = src;
+      f->channel = channel;
+      f->txpower = txpower;
+      f->start = now;
+      f->end = now + SIM_AIRTIME_US(len);
+      f->len = len;
+      memcpy(f->frame, frame, len);
+      return true;
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+/* Deliver the frames whose airtime is over, free those nothing overlaps any
+   more. Returns the time until the next end, -1 if none is on the air. */
+static int64_t
+air_update(int fd)
+{
+  uint64_t now = now_us();
+  int64_t next = -1;
+
+  for(int i = 0; i < AIR_SLOTS; i++) {
+    air_frame_t *f = &air[i];
+
+    if(!f->used) {
+      continue;
+    }
+    if(!f->ended && f->end <= now) {
+      deliver(fd, f);
+    }
+    if(f->ended) {
+      if(f->end + AIR_KEEP_US <= now) {
+        f->used = false;
+      }
+    } else if(next < 0 || (int64_t)(f->end - now) < next) {
+      next = f->end - now;
+    }
+  }
+  return next;
+}
+/*---------------------------------------------------------------------------*/
+static bool
+channel_busy(uint16_t id, int8_t threshold)
+{
+  for(int i = 0; i < AIR_SLOTS; i++) {
+    const air_frame_t *f = &air[i];
+
+    if(f->used && !f->ended && f->src != id &&
+       f->channel == nodes[id].channel &&
+       rssi_between(&nodes[f->src], &nodes[id], f->txpower) >= threshold) {
+      return true;
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+static int
+load_topology(const char *path)
+{
+  FILE *f = fopen(path, "r");
+  char line[128];
+  int count = 0;
+
+  if(f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while(fgets(line, sizeof(line), f) != NULL) {
+    unsigned id;
+    double x, y;
+
+    if(line[0] == '#' || sscanf(line, "%u %lf %lf", &id, &x, &y) != 3) {
+      continue;
+    }
+    if(id >= SIM_MAX_NODES) {
+      fprintf(stderr, "%s: node id %u too large\n", path, id);
+      continue;
+    }
+    nodes[id].placed = true;
+    nodes[id].x = x;
+    nodes[id].y = y;
+    count++;
+  }
+  fclose(f);
+  return count;
+}
+/*---------------------------------------------------------------------------*/
+static void
+on_signal(int sig)
+{
+  (void)sig;
+  stop = 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const char *path = SIM_MEDIUM_DEFAULT_PATH;
+  const char *topo = NULL;
+  long seed = 1;
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+  struct sigaction sa = { .sa_handler = on_signal };
+  int fd, opt, placed;
+
+  while((opt = getopt(argc, argv, "m:t:l:s:e:r:")) != -1) {
+    switch(opt) {
+    case 'm': path = optarg; break;
+    case 't': topo = optarg; break;
+    case 'l': extra_loss = atof(optarg); break;
+    case 's': seed = atol(optarg); break;
+    case 'e': path_loss_exp = atof(optarg); break;
+    case 'r': sensitivity_dbm = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s -t topology [-m path] [-l loss] [-s seed]"
+              " [-e exponent] [-r sensitivity]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(topo == NULL || (placed = load_topology(topo)) <= 0) {
+    fprintf(stderr, "%s: need a topology with at least one node (-t)\n", argv[0]);
+    return 1;
+  }
+  srand48(seed);
+
+  fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if(fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror(path);
+    return 1;
+  }
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  fprintf(stderr, "sim-medium: %d nodes, %s\n", placed, path);
+
+  while(!stop) {
+    uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+    struct sockaddr_un from;
+    socklen_t from_len = sizeof(from);
+    int64_t next = air_update(fd);
+    struct timespec wait = { .tv_sec = next / 1000000, .tv_nsec = next % 1000000 * 1000 };
+    struct pollfd p = { .fd = fd, .events = POLLIN };
+    ssize_t n;
+    sim_msg_hdr_t h;
+    sim_node_t *src;
+
+    if(ppoll(&p, 1, next < 0 ? NULL : &wait, NULL) <= 0) {
+      continue;                /* an airtime ended, or EINTR */
+    }
+    n = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+    if(n < (ssize_t)sizeof(h)) {
+      continue;                /* a runt */
+    }
+    memcpy(&h, buf, sizeof(h));
+    if(h.node >= SIM_MAX_NODES || h.len > n - sizeof(h)) {
+      continue;
+    }
+    src = &nodes[h.node];
+    if(h.type == SIM_MSG_HELLO) {
+      src->registered = true;
+      src->channel = h.channel;
+      src->txpower = h.txpower;
+      src->addr = from;
+      src->addr_len = from_len;
+    } else if(h.type == SIM_MSG_TX) {
+      sim_msg_hdr_t done = { .type = SIM_MSG_TX_DONE, .node = h.node, .status = SIM_TX_ERR };
+
+      /* TX_DONE comes when the airtime ends, unless the frame never got on */
+      if(!src->registered || !src->placed) {
+        src->addr = from;
+        src->addr_len = from_len;
+        send_to(fd, src, &done, NULL);
+      } else if(!transmit(h.node, h.channel, h.txpower, buf + sizeof(h), h.len)) {
+        send_to(fd, src, &done, NULL);
+      }
+    } else if(h.type == SIM_MSG_CCA && src->registered && src->placed) {
+      sim_msg_hdr_t done = { .type = SIM_MSG_CCA_DONE, .node = h.node,
+                             .status = SIM_CCA_CLEAR };
+
+      totals.cca++;
+      if(channel_busy(h.node, h.rssi)) {
+        done.status = SIM_CCA_BUSY;
+        totals.cca_busy++;
+      }
+      send_to(fd, src, &done, NULL);
+    }
+  }
+
+  fprintf(stderr, "sim-medium: %lu frames sent (%lu unicast), %lu received, %lu lost,"
+          " %lu collisions, %lu out of range, %lu acks, %lu acks lost,"
+          " %lu cca (%lu busy), %lu node queue overruns\n",
+          totals.tx, totals.unicast, totals.rx, totals.lost, totals.collisions,
+          totals.out_of_range, totals.acks, totals.ack_lost, totals.cca, totals.cca_busy,
+          totals.overruns);
+  unlink(path);
+  return 0;
+}
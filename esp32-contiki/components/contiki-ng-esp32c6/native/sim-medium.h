@@ -0,0 +1,70 @@
+/* sim-medium.h - messages between native nodes and the simulated medium
+ *
+ * Nodes and sim-medium exchange datagrams over UNIX sockets. The medium
+ * binds SIM_MEDIUM_DEFAULT_PATH (or the path given with -m). Each node
+ * binds "<medium path>.<node id>". A node announces itself, its channel and
+ * the power of its ACKs with HELLO, and sends frames with TX, each at its
+ * own power. A frame is on the air for
+ * SIM_AIRTIME_US from its TX. When that ends the medium forwards it as RX
+ * to each node in range that neither lost it nor heard another frame over
+ * it, and then answers the sender with TX_DONE. If the frame asks for an
+ * ACK and reached its destination, the medium also sends an RX carrying an
+ * 802.15.4 ACK back to the sender, before TX_DONE. CCA asks whether a frame
+ * at or above a threshold is on the air at the node, CCA_DONE answers.
+ *
+ * Plain C, shared by the node side (radio-native.c) and sim-medium.c.
+ */
+#ifndef SIM_MEDIUM_H_
+#define SIM_MEDIUM_H_
+
+#include <stdint.h>
+
+#define SIM_MEDIUM_DEFAULT_PATH  "/tmp/esp32c6-sim"
+#define SIM_MAX_NODES            1024
+#define SIM_MAX_FRAME            127
+
+/* 250 kbit/s: 32 us per byte, plus preamble, SFD and PHR */
+#define SIM_AIRTIME_US(len)      (((len) + 6) * 32)
+
+enum {
+  SIM_MSG_HELLO = 1,             /* node -> medium: register, channel */
+  SIM_MSG_TX,                    /* node -> medium: frame on channel */
+  SIM_MSG_TX_DONE,               /* medium -> node: status */
+  SIM_MSG_RX,                    /* medium -> node: frame, rssi, lqi */
+  SIM_MSG_CCA,                   /* node -> medium: threshold in rssi */
+  SIM_MSG_CCA_DONE,              /* medium -> node: status */
+};
+
+enum {
+  SIM_TX_OK,
+  SIM_TX_ERR,                    /* sender unknown to the medium */
+  SIM_CCA_CLEAR = SIM_TX_OK,
+  SIM_CCA_BUSY,
+};
+
+typedef struct __attribute__((packed)) {
+  uint8_t type;                  /* SIM_MSG_* */
+  uint8_t channel;
+  int8_t rssi;                   /* RX: dBm at the receiver, CCA: threshold */
+  uint8_t lqi;
+  uint16_t node;                 /* HELLO/TX: sender id */
+  uint16_t len;                  /* frame bytes following the header */
+  uint8_t status;                /* TX_DONE: SIM_TX_*, CCA_DONE: SIM_CCA_* */
+  int8_t txpower;                /* HELLO: dBm of its ACKs, TX: of the frame */
+  uint8_t pad[2];
+} sim_msg_hdr_t;
+
+/* Link-layer address of a node: 02:00:00:00:00:00:<id high>:<id low>.
+   frame802154 carries it byte-reversed in the frame. */
+static inline void
+sim_node_addr(uint16_t id, uint8_t addr[8])
+{
+  for(int i = 0; i < 8; i++) {
+    addr[i] = 0;
+  }
+  addr[0] = 0x02;
+  addr[6] = id >> 8;
+  addr[7] = id & 0xff;
+}
+
+#endif /* SIM_MEDIUM_H_ */
@@ -0,0 +1,84 @@
+/* native/udp-load.c - rpl-udp client that sends as often as asked
+ *
+ * Same ports and log lines as examples/rpl-udp/udp-client.c, so node-server
+ * answers it and tools/sim-rpl.py counts it. It sends every
+ * $SIM_SEND_INTERVAL ms (default 1000) instead of every minute, to load
+ * the medium.
+ */
+#include "contiki.h"
+#include "net/routing/routing.h"
+#include "net/netstack.h"
+#include "net/ipv6/simple-udp.h"
+#include "random.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sys/log.h"
+#define LOG_MODULE "App"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#define UDP_CLIENT_PORT  8765
+#define UDP_SERVER_PORT  5678
+
+#define SEND_INTERVAL_DEFAULT_MS  1000
+
+static struct simple_udp_connection udp_conn;
+
+PROCESS(udp_load_process, "UDP load client");
+AUTOSTART_PROCESSES(&udp_load_process);
+/*---------------------------------------------------------------------------*/
+static void
+udp_rx_callback(struct simple_udp_connection *c,
+                const uip_ipaddr_t *sender_addr, uint16_t sender_port,
+                const uip_ipaddr_t *receiver_addr, uint16_t receiver_port,
+                const uint8_t *data, uint16_t datalen)
+{
+  LOG_INFO("Received response '%.*s' from ", datalen, (char *)data);
+  LOG_INFO_6ADDR(sender_addr);
+  LOG_INFO_("\n");
+}
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(udp_load_process, ev, data)
+{
+  static struct etimer periodic_timer;
+  static clock_time_t interval;
+  static uint32_t tx_count;
+  static char str[32];
+  uip_ipaddr_t dest_ipaddr;
+  const char *env;
+
+  PROCESS_BEGIN();
+
+  env = getenv("SIM_SEND_INTERVAL");
+  interval = (env != NULL ? atoi(env) : SEND_INTERVAL_DEFAULT_MS) * CLOCK_SECOND / 1000;
+  if(interval < 2) {
+    interval = 2;
+  }
+  simple_udp_register(&udp_conn, UDP_CLIENT_PORT, NULL,
+                      UDP_SERVER_PORT, udp_rx_callback);
+
+  etimer_set(&periodic_timer, random_rand() % interval);
+  while(1) {
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+
+    if(NETSTACK_ROUTING.node_is_reachable() &&
+       NETSTACK_ROUTING.get_root_ipaddr(&dest_ipaddr)) {
+      LOG_INFO("Sending request %" PRIu32 " to ", tx_count);
+      LOG_INFO_6ADDR(&dest_ipaddr);
+      LOG_INFO_("\n");
+      snprintf(str, sizeof(str), "hello %" PRIu32 "", tx_count);
+      simple_udp_sendto(&udp_conn, str, strlen(str), &dest_ipaddr);
+      tx_count++;
+    } else {
+      LOG_INFO("Not reachable yet\n");
+    }
+
+    /* +-25% jitter so that the clients do not stay in step */
+    etimer_set(&periodic_timer, interval - interval / 4 + random_rand() % (interval / 2));
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,16 @@
+#include "contiki.h"
+#include "dev/watchdog.h"
+
+/* Nothing to feed on Linux */
+void watchdog_init(void)
+{
+}
+
+void watchdog_start(void)
+{
+}
+
+void
+watchdog_periodic(void)
+{
+}
@@ -37,12 +37,29 @@
 #define RPL_CONF_ENABLED        1
 #define NETSTACK_CONF_WITH_IPV6 1
 #define ROUTING_CONF_RPL_LITE   1
-#define NETSTACK_CONF_MAC       csma_driver
+#if !MAC_CONF_WITH_TSCH
+#define NETSTACK_CONF_MAC       esp32c6_csma_driver   /* csma_driver, see csma-pending.h; TSCH: CONFIG_CONTIKI_WITH_TSCH */
+#endif
 #define NETSTACK_CONF_FRAMER    framer_802154
-#define NETSTACK_CONF_RADIO     esp32c6_radio_driver
 
 #define LEDS_CONF_COUNT  1 // at least one LED on board
 
+/* ---------- RADIO DRIVER ----------------------------------------- */
+/* Received frames queued between the radio ISR and the radio process (power of two) */
+#ifndef ESP32C6_RADIO_CONF_RX_RING_SIZE
+#define ESP32C6_RADIO_CONF_RX_RING_SIZE  8
+#endif
+
+/* 1: sleep between periodic channel checks (radio-dc.c), see ESP32C6_DC_CONF_* */
+#ifndef ESP32C6_RADIO_CONF_DUTY_CYCLE
+#define ESP32C6_RADIO_CONF_DUTY_CYCLE    0
+#endif
+#if ESP32C6_RADIO_CONF_DUTY_CYCLE
+#define NETSTACK_CONF_RADIO     esp32c6_dc_radio_driver
+#else
+#define NETSTACK_CONF_RADIO     esp32c6_radio_driver
+#endif
+
 #define UIP_CONF_STATISTICS 1      /* let the header create uip_stats_t */
 typedef uint32_t uip_stats_t;             /* type expected by uip.h */
 
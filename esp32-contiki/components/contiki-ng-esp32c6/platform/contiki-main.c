@@ -9,6 +9,12 @@
 #include "esp_mac.h"
 #include "net/linkaddr.h"
 #include "net/net-debug.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "contiki-task.h"
+#include "lpm.h"
+#include "isr-bridge.h"
+#include "radio-esp32c6.h"
 
 /*---------------------------------------------------------------------------*/
 /* Log configuration */
@@ -17,8 +23,78 @@
 #define LOG_LEVEL LOG_LEVEL_MAIN
 /*---------------------------------------------------------------------------*/
 
+#ifdef CONTIKI_TASK_CONF_MAX_SLEEP_MS
+#define MAX_SLEEP_MS CONTIKI_TASK_CONF_MAX_SLEEP_MS
+#else
+#define MAX_SLEEP_MS 1000      /* wake up at least this often to feed the task watchdog */
+#endif
+
+static TaskHandle_t contiki_handle;
+static esp_timer_handle_t etimer_wake_timer;
+/*---------------------------------------------------------------------------*/
+void contiki_task_wake(void)
+{
+  if(contiki_handle != NULL) {
+    xTaskNotify(contiki_handle, CONTIKI_TASK_NOTIFY_WAKE, eSetBits);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void IRAM_ATTR contiki_task_wake_from_isr(BaseType_t *woken)
+{
+  if(contiki_handle != NULL) {
+    xTaskNotifyFromISR(contiki_handle, CONTIKI_TASK_NOTIFY_WAKE, eSetBits, woken);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void etimer_wake_cb(void *arg)
+{
+  contiki_task_wake();
+}
+/*---------------------------------------------------------------------------*/
+/* Block until something polls a process or the next etimer is due. The
+   esp_timer wakes us on the etimer deadline itself rather than on the next
+   FreeRTOS tick after it. */
+static void contiki_task_sleep(void)
+{
+  TickType_t ticks = pdMS_TO_TICKS(MAX_SLEEP_MS);
+  uint64_t wake_at = 0;
+
+  /* polled or queued since process_run() returned */
+  if(isr_bridge_pending() || process_nevents() > 0) {
+    return;
+  }
+  if(etimer_pending()) {
+    uint64_t deadline = clock_arch_time_to_us(etimer_next_expiration_time());
+    int64_t now = esp_timer_get_time();
+
+    if(deadline <= now) {
+      return;
+    }
+    if(deadline - now < MAX_SLEEP_MS * 1000ULL) {
+      esp_timer_start_once(etimer_wake_timer, deadline - now);
+      ticks = portMAX_DELAY;
+      wake_at = deadline;
+    }
+  }
+  /* with light sleep enabled, tickless idle sleeps until the first esp_timer
+     alarm: this deadline or a pending rtimer */
+  esp32c6_lpm_idle_begin(wake_at);
+  xTaskNotifyWait(0, CONTIKI_TASK_NOTIFY_WAKE, NULL, ticks);
+  esp32c6_lpm_idle_end();
+  esp_timer_stop(etimer_wake_timer);   /* woken early, or already fired */
+}
+/*---------------------------------------------------------------------------*/
+
 void contiki_task(void *arg)
 {
+  esp_timer_create_args_t wake_args = {
+    .callback = etimer_wake_cb,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "contiki_et"
+  };
+
+  contiki_handle = xTaskGetCurrentTaskHandle();
+  ESP_ERROR_CHECK(esp_timer_create(&wake_args, &etimer_wake_timer));
   clock_init();          /* your very first driver */
   rtimer_arch_init();          
 
@@ -27,7 +103,10 @@ void contiki_task(void *arg)
   vTaskDelay(pdMS_TO_TICKS(10));
 
   process_init();
+  isr_bridge_init();
   process_start(&etimer_process, NULL);
+  esp32c6_lpm_init();
+  rtimer_arch_bench_start();
 
   ctimer_init();
   watchdog_init();
@@ -71,21 +150,27 @@ void contiki_task(void *arg)
 
   /* Start the Contiki processes */
   autostart_start(autostart_processes);
+  esp32c6_radio_tx_bench_start();
 
 
   watchdog_start();
   while(1) {
+    /* polls and events queued by ISRs and other tasks */
+    isr_bridge_drain();
+
+    /* drive the e-timer engine once the first software timer is due */
+    if(etimer_pending() && !CLOCK_LT(clock_time(), etimer_next_expiration_time())) {
+      etimer_request_poll();
+    }
+
     /* run all pending events until none are left */
     while(process_run()) ;
 
-    /* drive the e-timer engine so software timers expire */
-    etimer_request_poll();
-
     /* feed the watchdog                                  */
     watchdog_periodic();
 
-    /* let the idle task run (and save power)             */
-    vTaskDelay(pdMS_TO_TICKS(10));  /* 10 ms ≈ 100 Hz scheduler tick   */
+    /* let the idle task run until there is work again    */
+    contiki_task_sleep();
   }
 }
 
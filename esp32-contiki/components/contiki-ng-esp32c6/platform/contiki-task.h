@@ -0,0 +1,27 @@
+/* contiki-task.h - waking the FreeRTOS task that runs Contiki
+ *
+ * contiki_task() blocks on a task notification between events. It wakes up
+ * at the next etimer deadline by itself. Code outside the task (an ISR, an
+ * rtimer callback, another FreeRTOS task) polls processes through
+ * isr-bridge.h, which wakes the task. Call the functions below directly
+ * only to wake the task for other reasons.
+ */
+#ifndef CONTIKI_TASK_H_
+#define CONTIKI_TASK_H_
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "contiki.h"
+
+/* Notification bit of the Contiki task, on the default index 0. The radio
+   waits for TX/CCA/ED completion on ESP32C6_RADIO_NOTIFY_INDEX, so those
+   waits never consume a wake-up. */
+#define CONTIKI_TASK_NOTIFY_WAKE  (1UL << 3)
+
+void contiki_task_wake(void);
+void contiki_task_wake_from_isr(BaseType_t *woken);
+
+/* clock.c: the esp_timer time at which clock_time() reaches t */
+uint64_t clock_arch_time_to_us(clock_time_t t);
+
+#endif /* CONTIKI_TASK_H_ */
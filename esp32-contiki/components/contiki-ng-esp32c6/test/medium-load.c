@@ -0,0 +1,663 @@
+/* medium-load.c - CSMA load on the simulated medium
+ *
+ *   medium-load <sim-medium executable> csma|txpower
+ *
+ * The networks of sim-rpl.py's csma and txpower scenarios without Contiki,
+ * for when the nodes cannot be built: a 4x4 grid at 10 m, node 1 in a corner
+ * answers requests, the others send one every interval +-25%, straight to
+ * node 1. Each node plays CSMA with csma-output.c's defaults over
+ * sim-medium's sockets:
+ * - a queue per neighbour, 8 frames in all;
+ * - a backoff of 0..2^BE-1 ms before each attempt, BE from 3, one more per
+ *   busy channel up to 5;
+ * - a frame dropped after 5 busy channels or 8 transmissions;
+ * - duplicates dropped by sequence number.
+ * Each run prints the delivery ratio (responses per request), retries per
+ * transmission (an attempt, CCA or not, that repeats the frame before),
+ * collisions per reception in range from the medium's totals, and the mean
+ * TX power, unicasts without ACK and energy radiated per response.
+ *
+ * csma: 500 ms for 20 s, without CCA and with send-on-CCA at radio-native.c's
+ * -75 dBm threshold. With CCA fewer receptions must be lost to collisions.
+ *
+ * txpower: 2 s for 30 s, at a fixed 0 dBm and with the power adapted per
+ * neighbour by arch/txpower-adapt.c from the ACK RSSI, as radio-native.c
+ * does with -a; ACKs go out at 0 dBm. Adapting must leave fewer unicasts
+ * without ACK and lower the power of some links, without losing responses.
+ * The energy is printed only: with every client one hop from the root, the
+ * farthest links arrive below the -85 dBm target at 0 dBm and are raised,
+ * and those cost more than the near links save. The module keeps one
+ * table, so the harness keys it by sender and destination together.
+ */
+#define _GNU_SOURCE            /* ppoll() */
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim-medium.h"
+#include "txpower-adapt.h"
+
+#define NODES          16
+#define COLUMNS        4
+#define SPACING        10
+#define CHANNEL        26
+#define DRAIN_MS       1000     /* after the last request, for the responses */
+#define FRAME_LEN      60       /* a compressed UDP request with its MAC header */
+#define CCA_THRESHOLD  -75
+#define TXPOWER_MIN    -24      /* radio-native.c's range */
+#define TXPOWER_MAX    20
+
+/* csma-output.c defaults */
+#define QUEUE_LEN      8        /* QUEUEBUF_NUM */
+#define MIN_BE         3
+#define MAX_BE         5
+#define MAX_BACKOFF    5
+#define MAX_TX         8        /* CSMA_MAX_FRAME_RETRIES + 1 */
+#define BACKOFF_US     1000     /* one clock tick */
+#define RADIO_TIMEOUT_US 100000 /* no TX_DONE/CCA_DONE: the medium dropped it */
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while(0)
+
+typedef struct {
+  const char *label;
+  int interval_ms;
+  int duration_s;
+  bool send_on_cca;
+  bool adapt;                   /* TX power per neighbour */
+} scenario_t;
+
+typedef struct {
+  uint8_t seq;
+  bool response;
+  uint16_t req;
+} frame_t;
+
+/* A CSMA neighbour queue */
+typedef struct {
+  frame_t q[QUEUE_LEN];
+  int head, count;
+  int collisions, transmissions;
+  bool tried;                   /* the head frame went out before */
+  uint64_t at;                  /* next attempt, 0: none */
+} neighbor_t;
+
+typedef struct {
+  int sock;
+  neighbor_t nbr[NODES + 1];
+  int queued;
+  enum { RADIO_IDLE, RADIO_CCA, RADIO_TX } radio;
+  uint64_t radio_since;
+  int active;                   /* neighbour of the frame in flight */
+  bool acked;
+  int8_t ack_rssi;
+  int8_t txpower;               /* of the frame in flight */
+  uint8_t seq;
+  int last_seq[NODES + 1];      /* per sender, -1: none yet */
+  uint64_t next_request;
+  uint16_t req;
+} node_t;
+
+typedef struct {
+  unsigned long requests, responses, attempts, retries, cca, cca_busy, drops;
+  unsigned long rx, lost, collisions;
+  unsigned long on_air, noack;
+  unsigned long lowered, raised;      /* txpower-adapt.c steps */
+  long dbm_sum;
+  double uj;
+} result_t;
+
+static node_t nodes[NODES + 1];
+static result_t res;
+static const scenario_t *sc;
+static struct sockaddr_un medium;
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+medium_send(int id, uint8_t type, const uint8_t *frame, uint16_t len, int8_t rssi,
+            int8_t txpower)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+  sim_msg_hdr_t h = { .type = type, .channel = CHANNEL, .node = id, .len = len,
+                      .rssi = rssi, .txpower = txpower };
+
+  memcpy(buf, &h, sizeof(h));
+  if(len > 0) {
+    memcpy(buf + sizeof(h), frame, len);
+  }
+  sendto(nodes[id].sock, buf, sizeof(h) + len, 0, (struct sockaddr *)&medium, sizeof(medium));
+}
+/*---------------------------------------------------------------------------*/
+/* Data frame, ACK requested, long addresses (byte-reversed, as frame802154) */
+static int
+frame_build(uint8_t *buf, int src, int dest, const frame_t *f)
+{
+  uint8_t addr[8];
+
+  memset(buf, 0, FRAME_LEN);
+  buf[0] = 0x61;
+  buf[1] = 0xdc;
+  buf[2] = f->seq;
+  buf[3] = 0xcd;
+  buf[4] = 0xab;
+  sim_node_addr(dest, addr);
+  for(int i = 0; i < 8; i++) {
+    buf[5 + i] = addr[7 - i];
+  }
+  sim_node_addr(src, addr);
+  for(int i = 0; i < 8; i++) {
+    buf[13 + i] = addr[7 - i];
+  }
+  buf[21] = f->response;
+  buf[22] = f->req & 0xff;
+  buf[23] = f->req >> 8;
+  return FRAME_LEN;
+}
+/*---------------------------------------------------------------------------*/
+/* txpower-adapt.c key of the link from src to dest */
+static void
+link_key(int src, int dest, uint8_t key[8])
+{
+  sim_node_addr(dest, key);
+  key[2] = src >> 8;
+  key[3] = src & 0xff;
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule(neighbor_t *n, uint64_t now)
+{
+  int be = n->collisions + MIN_BE < MAX_BE ? n->collisions + MIN_BE : MAX_BE;
+  int slots = (1 << be) - 1;
+
+  n->at = now + (uint64_t)(lrand48() % slots) * BACKOFF_US + 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+enqueue(int id, int dest, bool response, uint16_t req, uint64_t now)
+{
+  node_t *node = &nodes[id];
+  neighbor_t *n = &node->nbr[dest];
+  frame_t *f;
+
+  if(node->queued >= QUEUE_LEN) {
+    res.drops++;
+    return;
+  }
+  f = &n->q[(n->head + n->count) % QUEUE_LEN];
+  f->seq = ++node->seq;
+  f->response = response;
+  f->req = req;
+  node->queued++;
+  if(n->count++ == 0) {
+    n->tried = false;
+    schedule(n, now);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The head frame of n is done: sent, or dropped */
+static void
+tx_done(int id, neighbor_t *n, bool ok, uint64_t now)
+{
+  if(!ok) {
+    res.drops++;
+  }
+  n->head = (n->head + 1) % QUEUE_LEN;
+  n->count--;
+  nodes[id].queued--;
+  n->collisions = 0;
+  n->transmissions = 0;
+  n->tried = false;
+  n->at = 0;
+  if(n->count > 0) {
+    schedule(n, now);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+transmit(int id)
+{
+  node_t *node = &nodes[id];
+  neighbor_t *n = &node->nbr[node->active];
+  uint8_t buf[FRAME_LEN];
+  int len = frame_build(buf, id, node->active, &n->q[n->head]);
+
+  node->txpower = 0;
+  if(sc->adapt) {
+    uint8_t key[8];
+
+    link_key(id, node->active, key);
+    node->txpower = txpower_adapt_get(key, false);
+  }
+  node->acked = false;
+  node->radio = RADIO_TX;
+  node->radio_since = now_us();
+  medium_send(id, SIM_MSG_TX, buf, len, 0, node->txpower);
+}
+/*---------------------------------------------------------------------------*/
+/* The radio is free: start the neighbour whose backoff ended first */
+static void
+attempt(int id, uint64_t now)
+{
+  node_t *node = &nodes[id];
+  neighbor_t *n;
+  int best = 0;
+
+  for(int d = 1; d <= NODES; d++) {
+    n = &node->nbr[d];
+    if(n->at != 0 && n->at <= now && (best == 0 || n->at < node->nbr[best].at)) {
+      best = d;
+    }
+  }
+  if(best == 0) {
+    return;
+  }
+  n = &node->nbr[best];
+  n->at = 0;
+  node->active = best;
+  res.attempts++;
+  if(n->tried) {
+    res.retries++;
+  }
+  n->tried = true;
+  if(sc->send_on_cca) {
+    res.cca++;
+    node->radio = RADIO_CCA;
+    node->radio_since = now;
+    medium_send(id, SIM_MSG_CCA, NULL, 0, CCA_THRESHOLD, 0);
+  } else {
+    transmit(id);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+cca_done(int id, bool busy, uint64_t now)
+{
+  node_t *node = &nodes[id];
+  neighbor_t *n = &node->nbr[node->active];
+
+  if(!busy) {
+    transmit(id);
+    return;
+  }
+  res.cca_busy++;
+  node->radio = RADIO_IDLE;
+  if(++n->collisions > MAX_BACKOFF) {
+    tx_done(id, n, false, now);
+  } else {
+    schedule(n, now);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The frame in flight went on the air, and its ACK has come if any */
+static void
+on_air(int id)
+{
+  node_t *node = &nodes[id];
+
+  res.on_air++;
+  res.dbm_sum += node->txpower;
+  /* mW for the airtime in us gives nJ */
+  res.uj += pow(10.0, node->txpower / 10.0) * SIM_AIRTIME_US(FRAME_LEN) / 1000.0;
+  if(!node->acked) {
+    res.noack++;
+  }
+  if(sc->adapt) {
+    uint8_t key[8];
+
+    link_key(id, node->active, key);
+    txpower_adapt_update(key, false, node->acked, node->ack_rssi);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+radio_done(int id, uint64_t now)
+{
+  node_t *node = &nodes[id];
+  neighbor_t *n = &node->nbr[node->active];
+
+  node->radio = RADIO_IDLE;
+  if(node->acked) {
+    tx_done(id, n, true, now);
+    return;
+  }
+  n->collisions = 0;
+  if(++n->transmissions >= MAX_TX) {
+    tx_done(id, n, false, now);
+  } else {
+    schedule(n, now);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+rx(int id, const sim_msg_hdr_t *h, const uint8_t *frame, uint64_t now)
+{
+  node_t *node = &nodes[id];
+  uint8_t addr[8];
+  int src = h->node;
+  uint16_t req;
+
+  if(h->len == 3 && (frame[0] & 7) == 2) {
+    /* an ACK, for the frame in flight */
+    neighbor_t *n = &node->nbr[node->active];
+    if(node->radio == RADIO_TX && frame[2] == n->q[n->head].seq) {
+      node->acked = true;
+      node->ack_rssi = h->rssi;
+    }
+    return;
+  }
+  if(h->len != FRAME_LEN || src < 1 || src > NODES) {
+    return;
+  }
+  sim_node_addr(id, addr);
+  for(int i = 0; i < 8; i++) {
+    if(frame[5 + i] != addr[7 - i]) {
+      return;                   /* overheard */
+    }
+  }
+  if(node->last_seq[src] == frame[2]) {
+    return;                     /* a retry whose ACK got lost */
+  }
+  node->last_seq[src] = frame[2];
+  req = frame[22] | frame[23] << 8;
+  if(id == 1 && !frame[21]) {
+    enqueue(1, src, true, req, now);
+  } else if(id != 1 && frame[21]) {
+    res.responses++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_input(int id, uint64_t now)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+  sim_msg_hdr_t h;
+  ssize_t n;
+
+  while((n = recv(nodes[id].sock, buf, sizeof(buf), MSG_DONTWAIT)) >= (ssize_t)sizeof(h)) {
+    memcpy(&h, buf, sizeof(h));
+    if(h.type == SIM_MSG_RX) {
+      rx(id, &h, buf + sizeof(h), now);
+    } else if(h.type == SIM_MSG_TX_DONE && nodes[id].radio == RADIO_TX) {
+      if(h.status == SIM_TX_OK) {
+        on_air(id);
+      }
+      radio_done(id, now);
+    } else if(h.type == SIM_MSG_CCA_DONE && nodes[id].radio == RADIO_CCA) {
+      cca_done(id, h.status == SIM_CCA_BUSY, now);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Earliest thing to do after now, at most 10 ms away */
+static uint64_t
+next_event(uint64_t now, bool requests)
+{
+  uint64_t next = now + 10000;
+
+  for(int id = 1; id <= NODES; id++) {
+    node_t *node = &nodes[id];
+
+    if(requests && id != 1 && node->next_request < next) {
+      next = node->next_request;
+    }
+    if(node->radio != RADIO_IDLE) {
+      if(node->radio_since + RADIO_TIMEOUT_US < next) {
+        next = node->radio_since + RADIO_TIMEOUT_US;
+      }
+      continue;
+    }
+    for(int d = 1; d <= NODES; d++) {
+      if(node->nbr[d].at != 0 && node->nbr[d].at < next) {
+        next = node->nbr[d].at;
+      }
+    }
+  }
+  return next;
+}
+/*---------------------------------------------------------------------------*/
+/* Share of the receptions in range lost to collisions */
+static double
+collision_rate(const result_t *r)
+{
+  return (double)r->collisions / (r->rx + r->lost + r->collisions);
+}
+/*---------------------------------------------------------------------------*/
+static double
+pdr(const result_t *r)
+{
+  return r->requests ? (double)r->responses / r->requests : 0.0;
+}
+/*---------------------------------------------------------------------------*/
+/* Parses the medium's totals line into res */
+static void
+medium_totals(const char *line)
+{
+  const char *p = strstr(line, "received,");
+
+  while(p > line && p[-1] != ',') {
+    p--;
+  }
+  if(p == line || sscanf(p, " %lu received, %lu lost, %lu collisions",
+                         &res.rx, &res.lost, &res.collisions) != 3) {
+    printf("FAIL: no totals from the medium: %s\n", line);
+    failures++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(const char *exe, const scenario_t *scenario)
+{
+  char dir[] = "/tmp/medium-load-XXXXXX";
+  char topo[128], path[96], line[512] = "";
+  struct pollfd fds[NODES];
+  struct stat st;
+  uint64_t start, end, now;
+  int out[2], status;
+  pid_t pid;
+  FILE *f;
+
+  sc = scenario;
+  memset(&res, 0, sizeof(res));
+  memset(nodes, 0, sizeof(nodes));
+  srand48(1);
+  txpower_adapt_init(TXPOWER_MIN, TXPOWER_MAX, 0);
+  if(mkdtemp(dir) == NULL || pipe(out) < 0) {
+    perror("medium-load");
+    exit(2);
+  }
+  snprintf(topo, sizeof(topo), "%s/topology.txt", dir);
+  snprintf(path, sizeof(path), "%s/medium", dir);
+  f = fopen(topo, "w");
+  for(int i = 1; i <= NODES; i++) {
+    fprintf(f, "%d %d %d\n", i, (i - 1) % COLUMNS * SPACING, (i - 1) / COLUMNS * SPACING);
+  }
+  fclose(f);
+
+  pid = fork();
+  if(pid == 0) {
+    dup2(out[1], 2);
+    execl(exe, exe, "-t", topo, "-m", path, "-s", "1", (char *)NULL);
+    perror(exe);
+    _exit(2);
+  }
+  close(out[1]);
+  for(int i = 0; i < 200 && stat(path, &st) != 0; i++) {
+    usleep(10000);
+  }
+  medium.sun_family = AF_UNIX;
+  strncpy(medium.sun_path, path, sizeof(medium.sun_path) - 1);
+
+  start = now_us();
+  for(int id = 1; id <= NODES; id++) {
+    struct sockaddr_un self = { .sun_family = AF_UNIX };
+    node_t *node = &nodes[id];
+
+    snprintf(self.sun_path, sizeof(self.sun_path), "%s.%d", path, id);
+    node->sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(bind(node->sock, (struct sockaddr *)&self, sizeof(self)) < 0) {
+      perror(self.sun_path);
+      exit(2);
+    }
+    fds[id - 1].fd = node->sock;
+    fds[id - 1].events = POLLIN;
+    for(int s = 0; s <= NODES; s++) {
+      node->last_seq[s] = -1;
+    }
+    node->next_request = start + 100000 + lrand48() % (sc->interval_ms * 1000);
+    medium_send(id, SIM_MSG_HELLO, NULL, 0, 0, 0);
+  }
+  usleep(10000);
+
+  end = start + sc->duration_s * 1000000ULL;
+  while((now = now_us()) < end + DRAIN_MS * 1000) {
+    bool requests = now < end;
+    uint64_t next = next_event(now, requests);
+    struct timespec wait = { .tv_sec = 0, .tv_nsec = (long)(next > now ? next - now : 0) * 1000 };
+
+    if(ppoll(fds, NODES, &wait, NULL) > 0) {
+      now = now_us();
+      for(int id = 1; id <= NODES; id++) {
+        if(fds[id - 1].revents & POLLIN) {
+          node_input(id, now);
+        }
+      }
+    }
+    now = now_us();
+    for(int id = 2; id <= NODES && requests; id++) {
+      node_t *node = &nodes[id];
+
+      if(node->next_request <= now) {
+        enqueue(id, 1, false, ++node->req, now);
+        res.requests++;
+        node->next_request += (sc->interval_ms - sc->interval_ms / 4 +
+                               lrand48() % (sc->interval_ms / 2)) * 1000;
+      }
+    }
+    for(int id = 1; id <= NODES; id++) {
+      node_t *node = &nodes[id];
+
+      if(node->radio != RADIO_IDLE && node->radio_since + RADIO_TIMEOUT_US <= now) {
+        node->radio = RADIO_IDLE;       /* as if it had not been acked */
+        node->acked = false;
+        radio_done(id, now);
+      }
+      if(node->radio == RADIO_IDLE) {
+        attempt(id, now);
+      }
+    }
+  }
+
+  if(sc->adapt) {
+    txpower_adapt_stats_t steps;
+
+    txpower_adapt_get_stats(&steps);
+    res.lowered = steps.lowered;
+    res.raised = steps.raised;
+  }
+  kill(pid, SIGINT);
+  f = fdopen(out[0], "r");
+  while(fgets(line, sizeof(line), f) != NULL) {
+    if(strstr(line, "frames sent") != NULL) {
+      break;
+    }
+  }
+  fclose(f);
+  waitpid(pid, &status, 0);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  medium_totals(line);
+
+  for(int id = 1; id <= NODES; id++) {
+    char sock_path[128];
+
+    close(nodes[id].sock);
+    snprintf(sock_path, sizeof(sock_path), "%s.%d", path, id);
+    unlink(sock_path);
+  }
+  unlink(topo);
+  rmdir(dir);
+
+  printf("== %s, a request every %d ms, %d s\n", sc->label, sc->interval_ms,
+         sc->duration_s);
+  printf("PDR: %lu/%lu = %.3f\n", res.responses, res.requests, pdr(&res));
+  printf("radio: %lu attempts, retries %.3f per transmission, CCA busy %.3f of %lu checks,"
+         " %lu frames dropped\n", res.attempts,
+         res.attempts ? (double)res.retries / res.attempts : 0.0,
+         res.cca ? (double)res.cca_busy / res.cca : 0.0, res.cca, res.drops);
+  printf("medium: %lu collisions, %.3f of receptions in range\n", res.collisions,
+         collision_rate(&res));
+  printf("txpower: mean %.1f dBm over %lu frames, %lu unicasts without ACK,"
+         " %.1f uJ radiated, %.2f uJ per response\n",
+         res.on_air ? (double)res.dbm_sum / res.on_air : 0.0, res.on_air, res.noack,
+         res.uj, res.responses ? res.uj / res.responses : 0.0);
+  if(sc->adapt) {
+    printf("adaptation: %lu steps down, %lu up\n", res.lowered, res.raised);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static const scenario_t csma[] = {
+    { "CSMA, no CCA", 500, 20, false, false },
+    { "CSMA, send on CCA", 500, 20, true, false },
+  };
+  static const scenario_t txpower[] = {
+    { "TX power fixed at 0 dBm", 2000, 30, false, false },
+    { "TX power per neighbour", 2000, 30, false, true },
+  };
+  const scenario_t *runs;
+  result_t before, after;
+
+  if(argc != 3 || (strcmp(argv[2], "csma") != 0 && strcmp(argv[2], "txpower") != 0)) {
+    fprintf(stderr, "usage: %s <sim-medium> csma|txpower\n", argv[0]);
+    return 2;
+  }
+  runs = strcmp(argv[2], "csma") == 0 ? csma : txpower;
+  printf("%d nodes, %dx%d grid, %d m spacing\n", NODES, COLUMNS, NODES / COLUMNS, SPACING);
+  run(argv[1], &runs[0]);
+  before = res;
+  run(argv[1], &runs[1]);
+  after = res;
+
+  CHECK(before.requests > 0 && after.requests > 0);
+  CHECK(pdr(&after) >= pdr(&before) * 0.9);
+  if(runs == csma) {
+    CHECK(collision_rate(&after) < collision_rate(&before));
+  } else {
+    CHECK(before.dbm_sum == 0);
+    CHECK(after.noack < before.noack);
+    CHECK(after.lowered > 0);
+  }
+  if(failures) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("medium-load %s OK\n", argv[2]);
+  return 0;
+}
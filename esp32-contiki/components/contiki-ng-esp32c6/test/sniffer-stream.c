@@ -0,0 +1,55 @@
+/* sniffer-stream.c - write a sniffer UART stream for the host tests
+ *
+ * Builds records with the firmware's own encoder (sniffer-rec.h) and writes
+ * them to stdout, as a capture of the UART would contain them. Frame i has
+ * the contents tools/test_sniffer2pcapng.py expects:
+ *
+ *   psdu_len  3 + (37 i) % 125        psdu[k]  (13 i + k) & 0xff
+ *   channel   11 + i % 16             rssi     -20 - (3 i) % 80
+ *   lqi       (29 i) & 0xff           flags    SNIFFER_FLAG_FCS if i % 7 == 0
+ *   timestamp 0xfffff000 + 1234 i     lost     2 (i / 4)
+ *
+ * The timestamps cross 2^32. Line noise, including a stray sync pattern,
+ * goes between some records, and record BAD_CRC_INDEX has its CRC
+ * corrupted, so the decoder has to resynchronise and drop it.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sniffer-rec.h"
+
+#define FRAMES        40
+#define BAD_CRC_INDEX 17
+
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  static const uint8_t noise[] = { 0x00, 0xC5, 0x15, 0x01, 0x7F, 0xC5, 0xFF, 0x15 };
+  uint8_t psdu[127];
+  uint8_t hdr[SNIFFER_HDR_LEN];
+  uint8_t crc[SNIFFER_CRC_LEN];
+  int frames = argc > 1 ? atoi(argv[1]) : FRAMES;
+
+  for(int i = 0; i < frames; i++) {
+    uint8_t len = 3 + (37 * i) % 125;
+
+    for(int k = 0; k < len; k++) {
+      psdu[k] = (13 * i + k) & 0xff;
+    }
+    sniffer_rec_encode(hdr, crc, psdu, len, 11 + i % 16, -20 - (3 * i) % 80,
+                       (29 * i) & 0xff, i % 7 == 0 ? SNIFFER_FLAG_FCS : 0,
+                       0xfffff000ULL + 1234ULL * i, 2 * (i / 4));
+    if(i == BAD_CRC_INDEX) {
+      crc[0] ^= 0x5a;
+    }
+    if(i % 5 == 3) {
+      fwrite(noise, 1, sizeof(noise), stdout);
+    }
+    fwrite(hdr, 1, sizeof(hdr), stdout);
+    fwrite(psdu, 1, len, stdout);
+    fwrite(crc, 1, sizeof(crc), stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,300 @@
+/* test-dc-sched.c - host test of the duty-cycle schedule in dc-sched.h
+ *
+ * Drives the schedule from a simulated clock with radio-dc.c's default
+ * constants:
+ * - a receiver wakes once per period, always at its own phase;
+ * - a strobe towards a known phase starts before the receiver wakes and
+ *   lasts past its channel checks, and a broadcast strobe overlaps the
+ *   checks of a receiver at any phase;
+ * - the phase learnt from an ACK leads to a strobe that covers the
+ *   receiver's next wake-up;
+ * - a busy check keeps the radio on for the listen window, activity
+ *   extends it, and the receiver falls back to its phase afterwards;
+ * - periodic unicasts between two nodes, played as radio-dc.c sends them
+ *   (strobes of 60 byte frames, each followed by the ACK wait, CSMA's
+ *   retries after a NOACK) against a receiver doing three CCAs per wake-up:
+ *   every frame arrives, most on a known phase, with the added latency
+ *   under a period. Radio-on time of both ends and the latency are printed.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dc-sched.h"
+
+#define PERIOD      125000
+#define GUARD       2000
+#define CCA_COUNT   2
+#define CCA_GAP     1000
+#define CCA_US      128                 /* 8 symbols */
+#define CCA_WINDOW  (CCA_COUNT * CCA_GAP)
+#define LISTEN      10000
+
+/* Radio on for the checks at a wake-up */
+#define RX_WINDOW   (CCA_COUNT * CCA_US + (CCA_COUNT - 1) * CCA_GAP)
+/* A frame of len bytes with SHR, PHR and FCS, then the ACK wait (54 symbols)
+   and the turnaround before it is repeated */
+#define FRAME_US(len) ((6 + (len) + 2) * 32)
+#define REPEAT_GAP  (864 + 192)
+#define REPEAT(len) (FRAME_US(len) + REPEAT_GAP)
+#define ACK_US      (192 + 11 * 32)     /* turnaround and the ACK */
+#define CSMA_TRIES  8                   /* 1 + CSMA_MAX_FRAME_RETRIES */
+#define CSMA_BACKOFF 8000               /* up to 2^3 backoff periods of 1 ms */
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while(0)
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+random_time(void)
+{
+  return ((uint64_t)rand() << 16 | (uint64_t)(rand() & 0xFFFF)) % (1000ULL * PERIOD);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_wake_phase(void)
+{
+  for(int i = 0; i < 10000; i++) {
+    uint64_t now = random_time();
+    uint32_t phase = rand() % PERIOD;
+    uint64_t t = dc_next_wake(now, PERIOD, phase);
+
+    CHECK(t > now && t <= now + PERIOD);
+    CHECK(dc_phase_of(t, PERIOD) == phase);
+  }
+
+  /* a receiver rescheduling itself from each wake-up, also exactly on one */
+  dc_sched_t s = { .period = PERIOD, .phase = 4321, .listen = LISTEN };
+  uint64_t t = 0;
+  for(int i = 0; i < 100; i++) {
+    uint64_t next = dc_after_check(&s, t, false);
+    CHECK(!s.listening);
+    CHECK(dc_phase_of(next, PERIOD) == s.phase);
+    CHECK(i == 0 || next - t == PERIOD);
+    t = next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_strobe(void)
+{
+  uint32_t unicast = dc_strobe_len(PERIOD, GUARD, CCA_WINDOW, REPEAT(60), true);
+  uint32_t broadcast = dc_strobe_len(PERIOD, GUARD, CCA_WINDOW, REPEAT(60), false);
+
+  CHECK(unicast == 2 * GUARD + CCA_WINDOW + REPEAT(60));
+  CHECK(broadcast == PERIOD + CCA_WINDOW + REPEAT(60));
+  CHECK(RX_WINDOW > REPEAT_GAP);
+
+  for(int i = 0; i < 10000; i++) {
+    uint64_t now = random_time();
+    uint32_t phase = rand() % PERIOD;
+
+    /* known phase: wait for the receiver, then strobe over its checks */
+    uint64_t start = dc_strobe_start(now, PERIOD, phase, GUARD);
+    uint64_t wake = start + GUARD;
+    CHECK(start >= now && start < now + PERIOD);
+    CHECK(dc_phase_of(wake, PERIOD) == phase);
+    CHECK(start + unicast >= wake + CCA_WINDOW + REPEAT(60));
+
+    /* broadcast from now: a frame starts after any receiver's checks */
+    uint64_t rx_wake = dc_next_wake(now, PERIOD, phase);
+    CHECK(rx_wake + CCA_WINDOW + REPEAT(60) <= now + broadcast + 1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_phase_from_ack(void)
+{
+  for(int i = 0; i < 10000; i++) {
+    uint32_t phase = rand() % PERIOD;
+    uint64_t rx_wake = dc_next_wake(random_time(), PERIOD, phase);
+    int len = 10 + rand() % 116, next_len = 10 + rand() % 116;
+    /* the ACKed frame started less than one repetition after the wake-up */
+    uint64_t tx = rx_wake + rand() % REPEAT(len);
+    uint32_t learnt = dc_phase_from_ack(tx, PERIOD, GUARD, REPEAT(len));
+
+    /* the next unicast, sent some periods later, starts before the checks
+       end and goes on for a whole frame after the wake-up */
+    uint64_t now = tx + (1 + rand() % 8) * (uint64_t)PERIOD - PERIOD / 2;
+    uint64_t start = dc_strobe_start(now, PERIOD, learnt, GUARD);
+    uint64_t end = start + dc_strobe_len(PERIOD, GUARD, CCA_WINDOW, REPEAT(next_len), true);
+    uint64_t next_wake = dc_next_wake(start - RX_WINDOW, PERIOD, phase);
+    CHECK(start < next_wake + RX_WINDOW);
+    CHECK(end >= next_wake + REPEAT(next_len));
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_listen(void)
+{
+  dc_sched_t s = { .period = PERIOD, .phase = 50000, .listen = LISTEN };
+  uint64_t t = 50000;
+  uint64_t next;
+  int checks = 0;
+
+  /* busy: stay on, check again in a quarter window */
+  next = dc_after_check(&s, t, true);
+  CHECK(s.listening);
+  CHECK(next == t + LISTEN / 4);
+  CHECK(s.listen_until == t + LISTEN);
+
+  /* activity at each of the first three checks extends the window */
+  for(int i = 0; i < 3; i++) {
+    t = next;
+    next = dc_after_listen(&s, t, true);
+    CHECK(s.listening);
+    CHECK(s.listen_until == t + LISTEN);
+  }
+  uint64_t last_activity = t;
+
+  /* then quiet: on until the window has passed, then back to the phase */
+  while(s.listening) {
+    t = next;
+    next = dc_after_listen(&s, t, false);
+    checks++;
+    CHECK(checks < 10);
+    if(checks >= 10) {
+      break;
+    }
+  }
+  CHECK(t >= last_activity + LISTEN);
+  CHECK(t < last_activity + LISTEN + LISTEN / 4);
+  CHECK(next > t && dc_phase_of(next, PERIOD) == s.phase);
+  CHECK(next - t <= PERIOD);
+
+  /* the next check, if quiet, does not listen */
+  next = dc_after_check(&s, next, false);
+  CHECK(!s.listening);
+}
+/*---------------------------------------------------------------------------*/
+/* Receiver's channel check at wake-up w against a strobe of len byte frames
+   from s, repeated while they start before end. The radio is on from w to
+   the end of the last CCA: a frame starting then is received, one on the
+   air during a CCA is seen as busy.                                         */
+static bool
+strobe_detect(uint64_t w, uint64_t s, uint64_t end, int len)
+{
+  uint64_t k = w > s ? (w - s) / REPEAT(len) : 0;
+
+  for(; s + k * REPEAT(len) < end && s + k * REPEAT(len) < w + RX_WINDOW; k++) {
+    uint64_t f = s + k * REPEAT(len);
+
+    if(f >= w) {
+      return true;
+    }
+    for(int i = 0; i < CCA_COUNT; i++) {
+      uint64_t c = w + i * (CCA_GAP + CCA_US);
+      if(f < c + CCA_US && f + FRAME_US(len) > c) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+/* One unicast of len bytes every interval us (+-10%), frames of them, as
+   radio-dc.c sends it: the phase learnt from the last ACK, forgotten after
+   a NOACK, then CSMA's backoff and retries */
+static void
+test_traffic(uint32_t interval, int len, int frames)
+{
+  dc_sched_t rx = { .period = PERIOD, .phase = 77777, .listen = LISTEN };
+  uint64_t tx_on = 0, rx_extra = 0, latency_sum = 0, latency_max = 0;
+  uint64_t t = PERIOD;
+  bool phase_known = false;
+  uint32_t learnt = 0;
+  int delivered = 0, phase_hits = 0, misses = 0;
+
+  for(int n = 0; n < frames; n++) {
+    uint64_t queued;
+
+    t += interval - interval / 10 + rand() % (interval / 5);
+    queued = t;
+    for(int try = 0; try < CSMA_TRIES; try++) {
+      uint64_t s = phase_known ? dc_strobe_start(t, PERIOD, learnt, GUARD) : t;
+      uint64_t end = s + dc_strobe_len(PERIOD, GUARD, CCA_WINDOW, REPEAT(len), phase_known);
+      uint64_t w = dc_next_wake(s > RX_WINDOW ? s - RX_WINDOW : 0, PERIOD, rx.phase);
+      uint64_t ack = 0, f, next;
+      bool busy = false;
+
+      for(; w < end && !(busy = strobe_detect(w, s, end, len)); w += PERIOD) {
+      }
+      if(busy) {
+        /* the receiver takes the first frame that starts after it woke up */
+        f = s + (w > s ? (w - s + REPEAT(len) - 1) / REPEAT(len) * REPEAT(len) : 0);
+        if(f < end) {
+          ack = f + FRAME_US(len) + ACK_US;
+          phase_hits += phase_known;
+          phase_known = true;
+          learnt = dc_phase_from_ack(f, PERIOD, GUARD, REPEAT(len));
+        }
+        /* listen window, extended while the strobe goes on */
+        next = dc_after_check(&rx, w + RX_WINDOW, true);
+        while(rx.listening) {
+          uint64_t now = next;
+          next = dc_after_listen(&rx, now, now < (ack ? ack : end));
+          if(!rx.listening) {
+            rx_extra += now - w - RX_WINDOW;
+          }
+        }
+      }
+      if(ack != 0) {
+        tx_on += ack - s;
+        delivered++;
+        latency_sum += ack - queued;
+        if(ack - queued > latency_max) {
+          latency_max = ack - queued;
+        }
+        break;
+      }
+      tx_on += end - s + REPEAT(len);
+      misses++;
+      phase_known = false;
+      t = end + REPEAT(len) + rand() % CSMA_BACKOFF;
+    }
+  }
+
+  /* both ends also run their own periodic checks */
+  double total = (double)(t - PERIOD);
+  double idle = (double)RX_WINDOW / PERIOD;
+  double tx_pct = 100.0 * (idle + tx_on / total);
+  double rx_pct = 100.0 * (idle + rx_extra / total);
+  double latency = (double)latency_sum / frames;
+
+  printf("%3d bytes every %2.0f s: radio on %.2f%% sender, %.2f%% receiver (%.2f%% idle),"
+         " latency %.1f ms avg, %.1f ms max (%.1f ms always on), %d/%d on a known phase,"
+         " %d strobes missed\n",
+         len, interval / 1e6, tx_pct, rx_pct, 100.0 * idle, latency / 1000,
+         latency_max / 1000.0, (FRAME_US(len) + ACK_US) / 1000.0, phase_hits, frames, misses);
+  CHECK(delivered == frames);
+  CHECK(misses == 0);
+  CHECK(phase_hits == frames - 1);
+  CHECK(latency < PERIOD);
+  CHECK(rx_pct < 100.0 * idle + 100.0 * (2 * LISTEN) / interval);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+  srand(1);
+  test_wake_phase();
+  test_strobe();
+  test_phase_from_ack();
+  test_listen();
+  test_traffic(1000000, 60, 2000);
+  test_traffic(10000000, 60, 2000);
+  test_traffic(60000000, 60, 500);
+  test_traffic(10000000, 125, 2000);
+  if(failures) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("dc-sched OK\n");
+  return 0;
+}
@@ -0,0 +1,198 @@
+/* test-rx-ring.c - host test of the RX frame ring behind radio-esp32c6.c
+ *
+ * Single-threaded checks of order, the full ring and its counters, then a
+ * stress run: a pthread producer plays rx_done_cb()/add_packet_to_buf(),
+ * taking driver buffers from a pool, dropping bad lengths and counting a
+ * full ring as an overflow, while the consumer drains with peek/release
+ * and hands the buffers back. Frames must arrive in order, a slot must not
+ * be handed out again while it is queued, and every frame must be either
+ * received, dropped or counted as an overflow. The consumer pauses now and
+ * then so that the ring fills up.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "rx-ring.h"
+
+#define FRAMES       500000
+#define BUFFERS      (2 * RX_RING_SIZE)   /* the driver's RX buffers */
+#define BAD_EVERY    97                   /* every so many frames has a bad length */
+
+static rx_ring_t ring;
+static uint8_t buffers[BUFFERS][RX_RING_FRAME_LEN];
+static bool buffer_free[BUFFERS];         /* owned by the driver */
+static uint8_t slot_state[RX_RING_SIZE];  /* 0 free, 1 filled by the producer */
+static uint32_t sent, bad;
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while(0)
+
+/*---------------------------------------------------------------------------*/
+static void
+test_single_thread(void)
+{
+  rx_desc_t *d;
+  unsigned i;
+
+  memset(&ring, 0, sizeof(ring));
+  CHECK(rx_ring_peek(&ring) == NULL);
+  CHECK(rx_ring_empty(&ring));
+
+  /* three laps, filling the ring completely each time */
+  for(unsigned lap = 0; lap < 3; lap++) {
+    for(i = 0; i < RX_RING_SIZE; i++) {
+      d = rx_ring_alloc(&ring);
+      CHECK(d != NULL);
+      if(d == NULL) {
+        return;
+      }
+      d->len = i;
+      rx_ring_commit(&ring);
+    }
+    CHECK(rx_ring_count(&ring) == RX_RING_SIZE);
+    CHECK(rx_ring_alloc(&ring) == NULL);
+    CHECK(ring.overflows == lap + 1);
+    for(i = 0; i < RX_RING_SIZE; i++) {
+      d = rx_ring_peek(&ring);
+      CHECK(d != NULL && d->len == i);
+      CHECK(rx_ring_peek(&ring) == d);        /* peek does not consume */
+      rx_ring_release(&ring);
+    }
+    CHECK(rx_ring_peek(&ring) == NULL);
+    CHECK(rx_ring_count(&ring) == 0);
+  }
+  CHECK(ring.drops == 0);
+}
+/*---------------------------------------------------------------------------*/
+/* rx_done_cb() with a frame of len bytes, numbered n; as add_packet_to_buf() */
+static void
+rx_done(unsigned b, uint8_t len, uint32_t n)
+{
+  uint8_t *frame = buffers[b];
+  rx_desc_t *d;
+
+  frame[0] = len;
+  memcpy(frame + 1, &n, sizeof(n));
+  if(len < 2 || len > RX_RING_FRAME_LEN - 1) {
+    ring.drops++;
+    __atomic_store_n(&buffer_free[b], true, __ATOMIC_RELEASE);
+    return;
+  }
+  d = rx_ring_alloc(&ring);
+  if(d == NULL) {
+    __atomic_store_n(&buffer_free[b], true, __ATOMIC_RELEASE);
+    return;
+  }
+  if(__atomic_load_n(&slot_state[d - ring.slot], __ATOMIC_ACQUIRE) != 0) {
+    printf("FAIL: slot %d handed out while queued\n", (int)(d - ring.slot));
+    failures++;
+  }
+  d->buf = frame;
+  d->len = len - 2;
+  __atomic_store_n(&slot_state[d - ring.slot], 1, __ATOMIC_RELEASE);
+  rx_ring_commit(&ring);
+}
+/*---------------------------------------------------------------------------*/
+static void *
+producer(void *arg)
+{
+  unsigned b = 0;
+
+  (void)arg;
+  for(uint32_t n = 0; n < FRAMES; n++) {
+    /* the driver receives into its next free buffer */
+    while(!__atomic_load_n(&buffer_free[b], __ATOMIC_ACQUIRE)) {
+      b = (b + 1) % BUFFERS;
+      sched_yield();
+    }
+    buffer_free[b] = false;
+    if(n % BAD_EVERY == BAD_EVERY - 1) {
+      rx_done(b, 1, n);
+      bad++;
+    } else {
+      rx_done(b, 10 + n % 100, n);
+    }
+    b = (b + 1) % BUFFERS;
+  }
+  __atomic_store_n(&sent, FRAMES, __ATOMIC_RELEASE);
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_threads(void)
+{
+  pthread_t thread;
+  uint32_t received = 0, last = 0;
+  bool first = true;
+  rx_desc_t *d;
+
+  memset(&ring, 0, sizeof(ring));
+  for(int i = 0; i < BUFFERS; i++) {
+    buffer_free[i] = true;
+  }
+  pthread_create(&thread, NULL, producer, NULL);
+
+  for(;;) {
+    uint32_t n;
+
+    d = rx_ring_peek(&ring);
+    if(d == NULL) {
+      if(__atomic_load_n(&sent, __ATOMIC_ACQUIRE) == FRAMES && rx_ring_empty(&ring)) {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+    CHECK(__atomic_load_n(&slot_state[d - ring.slot], __ATOMIC_ACQUIRE) == 1);
+    memcpy(&n, d->buf + 1, sizeof(n));
+    if(d->len != d->buf[0] - 2 || d->len != 8 + n % 100 || (!first && n <= last)) {
+      printf("FAIL: frame %lu (len %u) after %lu\n",
+             (unsigned long)n, d->len, (unsigned long)last);
+      failures++;
+      break;
+    }
+    first = false;
+    last = n;
+    received++;
+    /* copy out, hand the buffer back to the driver, free the slot */
+    __atomic_store_n(&slot_state[d - ring.slot], 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&buffer_free[(d->buf - buffers[0]) / RX_RING_FRAME_LEN], true,
+                     __ATOMIC_RELEASE);
+    rx_ring_release(&ring);
+    if(received % 1000 == 0) {
+      usleep(100);                      /* let the ring fill up */
+    }
+  }
+  pthread_join(thread, NULL);
+
+  CHECK(ring.drops == bad);
+  CHECK(received + ring.drops + ring.overflows == FRAMES);
+  CHECK(rx_ring_count(&ring) == 0);
+  printf("%lu frames: %lu received, %lu dropped, %lu overflows\n",
+         (unsigned long)FRAMES, (unsigned long)received,
+         (unsigned long)ring.drops, (unsigned long)ring.overflows);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+  test_single_thread();
+  test_threads();
+  if(failures) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("rx-ring OK\n");
+  return 0;
+}
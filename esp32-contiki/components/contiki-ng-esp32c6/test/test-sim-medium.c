@@ -0,0 +1,330 @@
+/* test-sim-medium.c - host test of the native build's simulated medium
+ *
+ *   test-sim-medium <sim-medium executable>
+ *
+ * Starts sim-medium on a three-node line, 1 -- 2 -- 3 at 10 m spacing, and
+ * plays the nodes over its sockets:
+ * - a frame reaches the neighbour, and TX_DONE comes when its airtime ends;
+ * - CCA at node 2 is busy while node 1's frame is on the air at or above
+ *   the threshold, and clear afterwards;
+ * - frames from 1 and 3 at the same time collide at node 2, and a node
+ *   that is transmitting does not hear the other;
+ * - an ACK request to node 2 gets its ACK before TX_DONE;
+ * - a frame arrives weaker by as much as its TX power is lower, and an ACK
+ *   by as much as the receiver announced a lower power with HELLO.
+ */
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim-medium.h"
+
+#define NODES       3
+#define CHANNEL     26
+#define QUIET_MS    50          /* nothing more arrives after this long */
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while(0)
+
+static char medium_path[96];
+static struct sockaddr_un medium;
+static int sock[NODES + 1];
+static int8_t power[NODES + 1];          /* dBm, of the node's next message */
+
+typedef struct {
+  sim_msg_hdr_t h;
+  uint8_t frame[SIM_MAX_FRAME];
+  uint64_t at;                  /* us */
+} msg_t;
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+node_send(int id, uint8_t type, const uint8_t *frame, uint16_t len, int8_t rssi)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+  sim_msg_hdr_t h = { .type = type, .channel = CHANNEL, .node = id, .len = len,
+                      .rssi = rssi, .txpower = power[id] };
+
+  memcpy(buf, &h, sizeof(h));
+  if(len > 0) {
+    memcpy(buf + sizeof(h), frame, len);
+  }
+  sendto(sock[id], buf, sizeof(h) + len, 0, (struct sockaddr *)&medium, sizeof(medium));
+}
+/*---------------------------------------------------------------------------*/
+/* Next message for node id within timeout_ms, false if none */
+static bool
+node_recv(int id, msg_t *m, int timeout_ms)
+{
+  uint8_t buf[sizeof(sim_msg_hdr_t) + SIM_MAX_FRAME];
+  struct pollfd p = { .fd = sock[id], .events = POLLIN };
+  ssize_t n;
+
+  if(poll(&p, 1, timeout_ms) <= 0) {
+    return false;
+  }
+  n = recv(sock[id], buf, sizeof(buf), 0);
+  m->at = now_us();
+  if(n < (ssize_t)sizeof(m->h)) {
+    return false;
+  }
+  memcpy(&m->h, buf, sizeof(m->h));
+  memcpy(m->frame, buf + sizeof(m->h), n - sizeof(m->h));
+  return true;
+}
+/*---------------------------------------------------------------------------*/
+/* Count what node id receives until it is quiet: RX frames, and the time
+   of the first message of type `type` if want_at is set */
+static int
+rx_until_quiet(int id, uint8_t type, uint64_t *want_at)
+{
+  msg_t m;
+  int rx = 0;
+
+  while(node_recv(id, &m, QUIET_MS)) {
+    if(m.h.type == SIM_MSG_RX) {
+      rx++;
+    }
+    if(want_at != NULL && m.h.type == type && *want_at == 0) {
+      *want_at = m.at;
+    }
+  }
+  return rx;
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_airtime(void)
+{
+  uint8_t frame[100] = { 0x41, 0xd8, 1, 0xcd, 0xab, 0xff, 0xff };  /* broadcast */
+  uint64_t start = now_us(), done = 0, rx_at = 0;
+  msg_t m;
+
+  node_send(1, SIM_MSG_TX, frame, sizeof(frame), 0);
+  CHECK(node_recv(2, &m, 1000));
+  rx_at = m.at;
+  CHECK(m.h.type == SIM_MSG_RX && m.h.len == sizeof(frame) && m.h.node == 1);
+  CHECK(m.h.rssi < -60 && m.h.rssi > -80);
+  CHECK(memcmp(m.frame, frame, sizeof(frame)) == 0);
+  CHECK(rx_until_quiet(1, SIM_MSG_TX_DONE, &done) == 0);
+  CHECK(done != 0);
+  CHECK(rx_at - start >= SIM_AIRTIME_US(sizeof(frame)));
+  CHECK(done - start >= SIM_AIRTIME_US(sizeof(frame)));
+  CHECK(rx_until_quiet(3, 0, NULL) == 1);     /* 20 m is still in range */
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_cca(void)
+{
+  uint8_t frame[SIM_MAX_FRAME] = { 0x41, 0xd8, 2, 0xcd, 0xab, 0xff, 0xff };
+  msg_t m;
+
+  /* -70 dBm at node 2 */
+  node_send(1, SIM_MSG_TX, frame, sizeof(frame), 0);
+  usleep(500);
+  node_send(2, SIM_MSG_CCA, NULL, 0, -75);
+  CHECK(node_recv(2, &m, 1000) && m.h.type == SIM_MSG_CCA_DONE);
+  CHECK(m.h.status == SIM_CCA_BUSY);
+  node_send(2, SIM_MSG_CCA, NULL, 0, -65);
+  CHECK(node_recv(2, &m, 1000) && m.h.type == SIM_MSG_CCA_DONE);
+  CHECK(m.h.status == SIM_CCA_CLEAR);
+  /* the sender's own frame does not make its channel busy */
+  node_send(1, SIM_MSG_CCA, NULL, 0, -75);
+  CHECK(node_recv(1, &m, 1000) && m.h.type == SIM_MSG_CCA_DONE);
+  CHECK(m.h.status == SIM_CCA_CLEAR);
+  CHECK(rx_until_quiet(1, 0, NULL) == 0);
+  CHECK(rx_until_quiet(2, 0, NULL) == 1);
+  rx_until_quiet(3, 0, NULL);
+
+  node_send(2, SIM_MSG_CCA, NULL, 0, -75);
+  CHECK(node_recv(2, &m, 1000) && m.h.type == SIM_MSG_CCA_DONE);
+  CHECK(m.h.status == SIM_CCA_CLEAR);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_collision(void)
+{
+  uint8_t a[60] = { 0x41, 0xd8, 3, 0xcd, 0xab, 0xff, 0xff };
+  uint8_t b[40] = { 0x41, 0xd8, 4, 0xcd, 0xab, 0xff, 0xff };
+  uint64_t done1 = 0, done3 = 0;
+
+  /* equally strong at node 2, so neither survives; 1 and 3 are deaf */
+  node_send(1, SIM_MSG_TX, a, sizeof(a), 0);
+  node_send(3, SIM_MSG_TX, b, sizeof(b), 0);
+  CHECK(rx_until_quiet(2, 0, NULL) == 0);
+  CHECK(rx_until_quiet(1, SIM_MSG_TX_DONE, &done1) == 0);
+  CHECK(rx_until_quiet(3, SIM_MSG_TX_DONE, &done3) == 0);
+  CHECK(done1 != 0 && done3 != 0);
+
+  /* one after the other both get through */
+  node_send(1, SIM_MSG_TX, a, sizeof(a), 0);
+  CHECK(rx_until_quiet(1, 0, NULL) == 0);
+  node_send(3, SIM_MSG_TX, b, sizeof(b), 0);
+  CHECK(rx_until_quiet(3, 0, NULL) == 1);
+  CHECK(rx_until_quiet(2, 0, NULL) == 2);
+  CHECK(rx_until_quiet(1, 0, NULL) == 1);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_ack(void)
+{
+  uint8_t frame[30] = { 0x61, 0xdc, 5, 0xcd, 0xab };   /* ack request, long addresses */
+  uint8_t addr[8];
+  msg_t m;
+
+  sim_node_addr(2, addr);
+  for(int i = 0; i < 8; i++) {
+    frame[5 + i] = addr[7 - i];
+  }
+  node_send(1, SIM_MSG_TX, frame, sizeof(frame), 0);
+  CHECK(node_recv(1, &m, 1000));
+  CHECK(m.h.type == SIM_MSG_RX && m.h.len == 3 && m.frame[0] == 0x02 && m.frame[2] == 5);
+  CHECK(node_recv(1, &m, 1000) && m.h.type == SIM_MSG_TX_DONE && m.h.status == SIM_TX_OK);
+  CHECK(rx_until_quiet(2, 0, NULL) == 1);
+  rx_until_quiet(3, 0, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_txpower(void)
+{
+  uint8_t bcast[20] = { 0x41, 0xd8, 6, 0xcd, 0xab, 0xff, 0xff };
+  uint8_t frame[30] = { 0x61, 0xdc, 7, 0xcd, 0xab };
+  uint8_t addr[8];
+  int8_t full, ack_full;
+  msg_t m;
+
+  node_send(1, SIM_MSG_TX, bcast, sizeof(bcast), 0);
+  CHECK(node_recv(2, &m, 1000) && m.h.type == SIM_MSG_RX);
+  full = m.h.rssi;
+  rx_until_quiet(1, 0, NULL);
+  rx_until_quiet(3, 0, NULL);
+
+  power[1] = -10;
+  bcast[2]++;
+  node_send(1, SIM_MSG_TX, bcast, sizeof(bcast), 0);
+  CHECK(node_recv(2, &m, 1000) && m.h.type == SIM_MSG_RX);
+  CHECK(m.h.rssi == full - 10);
+  rx_until_quiet(1, 0, NULL);
+  rx_until_quiet(3, 0, NULL);
+  power[1] = 0;
+
+  sim_node_addr(2, addr);
+  for(int i = 0; i < 8; i++) {
+    frame[5 + i] = addr[7 - i];
+  }
+  node_send(1, SIM_MSG_TX, frame, sizeof(frame), 0);
+  CHECK(node_recv(1, &m, 1000) && m.h.len == 3);
+  ack_full = m.h.rssi;
+  rx_until_quiet(1, 0, NULL);
+  rx_until_quiet(2, 0, NULL);
+  rx_until_quiet(3, 0, NULL);
+
+  power[2] = -6;
+  node_send(2, SIM_MSG_HELLO, NULL, 0, 0);
+  usleep(10000);
+  frame[2]++;
+  node_send(1, SIM_MSG_TX, frame, sizeof(frame), 0);
+  CHECK(node_recv(1, &m, 1000) && m.h.len == 3 && m.frame[2] == frame[2]);
+  CHECK(m.h.rssi == ack_full - 6);
+  rx_until_quiet(1, 0, NULL);
+  rx_until_quiet(2, 0, NULL);
+  rx_until_quiet(3, 0, NULL);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  char dir[] = "/tmp/test-sim-medium-XXXXXX";
+  char topo[128];
+  struct stat st;
+  pid_t pid;
+  FILE *f;
+  int status;
+
+  if(argc != 2 || mkdtemp(dir) == NULL) {
+    fprintf(stderr, "usage: %s <sim-medium>\n", argv[0]);
+    return 2;
+  }
+  snprintf(topo, sizeof(topo), "%s/topology.txt", dir);
+  snprintf(medium_path, sizeof(medium_path), "%s/medium", dir);
+  f = fopen(topo, "w");
+  for(int i = 1; i <= NODES; i++) {
+    fprintf(f, "%d %d 0\n", i, (i - 1) * 10);
+  }
+  fclose(f);
+
+  pid = fork();
+  if(pid == 0) {
+    execl(argv[1], argv[1], "-t", topo, "-m", medium_path, (char *)NULL);
+    perror(argv[1]);
+    _exit(2);
+  }
+  for(int i = 0; i < 200 && stat(medium_path, &st) != 0; i++) {
+    usleep(10000);
+  }
+  medium.sun_family = AF_UNIX;
+  strncpy(medium.sun_path, medium_path, sizeof(medium.sun_path) - 1);
+
+  for(int i = 1; i <= NODES; i++) {
+    struct sockaddr_un self = { .sun_family = AF_UNIX };
+
+    snprintf(self.sun_path, sizeof(self.sun_path), "%s.%d", medium_path, i);
+    sock[i] = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(bind(sock[i], (struct sockaddr *)&self, sizeof(self)) < 0) {
+      perror(self.sun_path);
+      return 2;
+    }
+    node_send(i, SIM_MSG_HELLO, NULL, 0, 0);
+  }
+  usleep(10000);
+
+  test_airtime();
+  test_cca();
+  test_collision();
+  test_ack();
+  test_txpower();
+
+  kill(pid, SIGTERM);
+  waitpid(pid, &status, 0);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  for(int i = 1; i <= NODES; i++) {
+    char path[128];
+
+    close(sock[i]);
+    snprintf(path, sizeof(path), "%s.%d", medium_path, i);
+    unlink(path);
+  }
+  unlink(topo);
+  rmdir(dir);
+
+  if(failures) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("sim-medium OK\n");
+  return 0;
+}
@@ -0,0 +1,203 @@
+/* test-txpower-adapt.c - host test of the TX power adaptation in txpower-adapt.h
+ *
+ * Drives the module over simulated links with sim-medium's default model:
+ * log-distance path loss (40 dB at 1 m, exponent 3), the same loss both
+ * ways, reception rising around -94 dBm, ACKs at the default power of
+ * radio-esp32c6.c:
+ * - on a clean link the power settles at the lowest step whose frames
+ *   still arrive at or above the target, and stays there;
+ * - a link that gets worse raises the power until ACKs return;
+ * - with a full table the least recently used neighbour is forgotten;
+ * - over lossy links that 0 dBm covers, the delivery stays within 1% of a
+ *   fixed 0 dBm for less radiated energy; on a link it does not cover,
+ *   more frames are acked, and lost ACKs do not pin the power high. The
+ *   figures are printed.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "txpower-adapt.h"
+
+#define POWER_MIN      -24
+#define POWER_MAX      20
+#define POWER_DEFAULT  0
+#define SENSITIVITY    -94.0
+#define PRR_SLOPE_DB   1.5
+
+static int failures;
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while(0)
+
+/*---------------------------------------------------------------------------*/
+static double
+path_loss(double d)
+{
+  return 40.0 + 30.0 * log10(d < 1.0 ? 1.0 : d);
+}
+/*---------------------------------------------------------------------------*/
+/* As sim-medium: certain above sensitivity + 3 dB when not lossy */
+static bool
+received(double rssi, bool lossy)
+{
+  if(!lossy) {
+    return rssi >= SENSITIVITY + 3.0;
+  }
+  return drand48() < 1.0 / (1.0 + exp(-(rssi - SENSITIVITY - 3.0) / PRR_SLOPE_DB));
+}
+/*---------------------------------------------------------------------------*/
+/* One unicast to addr over a link with the given loss; true if acked */
+static bool
+send_frame(const uint8_t *addr, double loss, bool lossy, bool adapt, double *energy)
+{
+  int8_t power = adapt ? txpower_adapt_get(addr, true) : POWER_DEFAULT;
+  double ack_rssi = POWER_DEFAULT - loss;
+  bool acked = received(power - loss, lossy) && received(ack_rssi, lossy);
+
+  *energy += pow(10.0, power / 10.0);
+  if(adapt) {
+    txpower_adapt_update(addr, true, acked, (int8_t)lround(ack_rssi));
+  }
+  return acked;
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_settle(void)
+{
+  static const double distances[] = { 2, 5, 10, 20, 30, 40 };
+  double energy = 0;
+
+  txpower_adapt_init(POWER_MIN, POWER_MAX, POWER_DEFAULT);
+  for(unsigned i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+    uint8_t addr[2] = { 1, i };
+    double loss = path_loss(distances[i]);
+    int8_t power;
+    int est;
+
+    for(int n = 0; n < 100; n++) {
+      send_frame(addr, loss, false, true, &energy);
+    }
+    power = txpower_adapt_get(addr, true);
+    est = (int)lround(power - loss);
+    for(int n = 0; n < 50; n++) {
+      CHECK(send_frame(addr, loss, false, true, &energy));
+    }
+    CHECK(txpower_adapt_get(addr, true) == power);
+    CHECK(est >= TXPOWER_ADAPT_TARGET_RSSI || power == POWER_MAX);
+    CHECK(est < TXPOWER_ADAPT_TARGET_RSSI + TXPOWER_ADAPT_MARGIN || power == POWER_MIN);
+    printf("%4.0f m: %3d dBm, frames arrive at %d dBm\n", distances[i], power, est);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_worse_link(void)
+{
+  uint8_t addr[2] = { 2, 0 };
+  double loss = path_loss(10);
+  double energy = 0;
+  int8_t settled;
+  int n;
+
+  txpower_adapt_init(POWER_MIN, POWER_MAX, POWER_DEFAULT);
+  for(n = 0; n < 100; n++) {
+    send_frame(addr, loss, false, true, &energy);
+  }
+  settled = txpower_adapt_get(addr, true);
+
+  /* 20 dB more, say a door closes: the settled power loses its ACKs */
+  loss += 20.0;
+  CHECK(!send_frame(addr, loss, false, true, &energy));
+  for(n = 0; n < 5 && !send_frame(addr, loss, false, true, &energy); n++) {
+  }
+  CHECK(n < 5);
+  for(n = 0; n < 20; n++) {
+    send_frame(addr, loss, false, true, &energy);
+  }
+  CHECK(txpower_adapt_get(addr, true) - loss >= TXPOWER_ADAPT_TARGET_RSSI);
+  CHECK(txpower_adapt_get(addr, true) > settled);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_eviction(void)
+{
+  txpower_adapt_stats_t s;
+  uint8_t addr[2] = { 3, 0 };
+  double energy = 0;
+
+  txpower_adapt_init(POWER_MIN, POWER_MAX, POWER_DEFAULT);
+  for(int i = 0; i < TXPOWER_ADAPT_NEIGHBORS; i++) {
+    addr[1] = i;
+    for(int n = 0; n < 20; n++) {
+      send_frame(addr, path_loss(2), false, true, &energy);
+    }
+    CHECK(txpower_adapt_get(addr, true) < POWER_DEFAULT);
+  }
+  addr[1] = 0;
+  txpower_adapt_get(addr, true);        /* 0 is used again, 1 is now oldest */
+  addr[1] = TXPOWER_ADAPT_NEIGHBORS;
+  send_frame(addr, path_loss(2), false, true, &energy);
+
+  txpower_adapt_get_stats(&s);
+  CHECK(s.evictions == 1);
+  addr[1] = 1;
+  CHECK(txpower_adapt_get(addr, true) == POWER_DEFAULT);
+  addr[1] = 0;
+  CHECK(txpower_adapt_get(addr, true) < POWER_DEFAULT);
+}
+/*---------------------------------------------------------------------------*/
+static void
+test_lossy(void)
+{
+  static const double distances[] = { 2, 5, 10, 20, 30, 40 };
+  const int frames = 2000;
+
+  for(unsigned i = 0; i < sizeof(distances) / sizeof(distances[0]); i++) {
+    uint8_t addr[2] = { 4, i };
+    double loss = path_loss(distances[i]);
+    double energy[2] = { 0, 0 };
+    int acked[2] = { 0, 0 };
+
+    for(int adapt = 0; adapt <= 1; adapt++) {
+      srand48(1);
+      txpower_adapt_init(POWER_MIN, POWER_MAX, POWER_DEFAULT);
+      for(int n = 0; n < frames; n++) {
+        acked[adapt] += send_frame(addr, loss, true, adapt, &energy[adapt]);
+      }
+    }
+    printf("%4.0f m lossy: %d dBm fixed %d/%d acked, adaptive %d/%d acked"
+           " for %.0f%% of the energy\n", distances[i], POWER_DEFAULT,
+           acked[0], frames, acked[1], frames, 100.0 * energy[1] / energy[0]);
+    if(POWER_DEFAULT - loss >= TXPOWER_ADAPT_TARGET_RSSI) {
+      CHECK(acked[1] >= acked[0] - frames / 100);
+      CHECK(energy[1] <= energy[0]);
+    } else {
+      /* mean power within two steps of what the target needs */
+      double need = TXPOWER_ADAPT_TARGET_RSSI + loss;
+
+      CHECK(acked[1] > acked[0]);
+      CHECK(10.0 * log10(energy[1] / frames) <= need + 2 * TXPOWER_ADAPT_STEP);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+  test_settle();
+  test_worse_link();
+  test_eviction();
+  test_lossy();
+  if(failures) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("txpower-adapt OK\n");
+  return 0;
+}
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Summarise rtimer firing errors logged by the rtimer benchmark.
+
+Build with ESP32C6_RTIMER_CONF_BENCH set to the number of alarms (and
+ESP32C6_RTIMER_CONF_GPTIMER 0 or 1 for the backend), capture the log, e.g.
+with `idf.py monitor | tee run.log`, then:
+
+  rtimer-jitter.py esp_timer.log gptimer.log
+
+Samples are grouped by backend, so both can also come from one log.
+"""
+import argparse
+import math
+import re
+import sys
+from collections import OrderedDict
+
+LINE = re.compile(r"rtimer bench (\S+) samples:((?: -?\d+)+)")
+
+
+def percentile(sorted_v, p):
+    if not sorted_v:
+        return 0
+    k = (len(sorted_v) - 1) * p / 100.0
+    lo, hi = math.floor(k), math.ceil(k)
+    return sorted_v[lo] + (sorted_v[hi] - sorted_v[lo]) * (k - lo)
+
+
+def histogram(values, width=40):
+    edges = [0, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024]
+    counts = [0] * (len(edges) + 1)
+    for v in values:
+        if v < 0:
+            counts[0] += 1
+            continue
+        i = 1
+        while i < len(edges) and v >= edges[i]:
+            i += 1
+        counts[i] += 1
+    labels = ["early"] + [f"<{e} us" for e in edges[1:]] + [f">={edges[-1]} us"]
+    top = max(counts) or 1
+    for label, c in zip(labels, counts):
+        if c:
+            print(f"  {label:>10} {c:7d} {'#' * max(1, c * width // top)}")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("logs", nargs="*", help="log files, stdin if none")
+    args = ap.parse_args()
+
+    runs = OrderedDict()
+    files = [open(f, errors="replace") for f in args.logs] or [sys.stdin]
+    for f in files:
+        for line in f:
+            m = LINE.search(line)
+            if m:
+                runs.setdefault(m.group(1), []).extend(int(v) for v in m.group(2).split())
+    if not runs:
+        sys.exit("no 'rtimer bench' samples found")
+
+    for backend, values in runs.items():
+        v = sorted(values)
+        mean = sum(v) / len(v)
+        sd = math.sqrt(sum((x - mean) ** 2 for x in v) / len(v))
+        print(f"{backend}: {len(v)} alarms, firing error in us")
+        print(f"  min {v[0]}  p50 {percentile(v, 50):.0f}  p90 {percentile(v, 90):.0f}"
+              f"  p99 {percentile(v, 99):.0f}  p99.9 {percentile(v, 99.9):.0f}  max {v[-1]}")
+        print(f"  mean {mean:.1f}  stddev {sd:.1f}")
+        histogram(v)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""Run an RPL network of native nodes on the simulated medium.
+
+Builds a topology, starts sim-medium, one node-server (node 1, the RPL
+root) and N-1 node-clients from the native build, and reports:
+
+  convergence   time until a client first finds the root reachable
+                (its first "Sending request"), median and max over clients
+  PDR           responses received / requests sent by the clients
+  latency       request to response round-trip time, median and p95
+  radio         CSMA retries (a frame sent again) per transmission, CCA
+                busy per check, summed over the nodes
+  txpower       mean TX power of the frames on the air, unicasts without
+                an ACK, and the energy radiated per response received
+  medium        receptions lost to collisions, per reception in range
+
+Scenarios run the network more than once and compare:
+
+  csma          node-load clients (every --interval ms) on a dense grid,
+                without and with send-on-CCA (node -c)
+  txpower       node-load clients on a grid, at a fixed 0 dBm and with
+                the TX power adapted per neighbour (node -a)
+
+  cmake -S components/contiki-ng-esp32c6/native -B build-native
+  cmake --build build-native
+  tools/sim-rpl.py -b build-native -n 25 --layout grid -d 600
+  tools/sim-rpl.py -b build-native --scenario csma
+
+With --min-pdr the exit status tells whether every client reached the
+root and enough responses came back. ctest runs a short network that way
+when the nodes are built.
+"""
+import argparse
+import math
+import os
+import random
+import re
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+SEND = re.compile(r"Sending request (\d+)")
+RESPONSE = re.compile(r"Received response")
+RADIO = re.compile(r"radio: (\d+) transmissions, (\d+) repeated, (\d+) cca checks, (\d+) busy,"
+                   r" (\d+) on air, (\d+) no ack, (-?\d+) dBm total, ([\d.]+) uJ radiated")
+MEDIUM = re.compile(r"(\d+) received, (\d+) lost, (\d+) collisions")
+
+# scenario: defaults, then one (label, client, node flags) per run
+SCENARIOS = {
+    "csma": (dict(nodes=16, spacing=10.0, duration=120.0, interval=500),
+             [("CSMA, no CCA", "node-load", []),
+              ("CSMA, send on CCA", "node-load", ["-c"])]),
+    "txpower": (dict(nodes=16, spacing=10.0, duration=120.0, interval=2000),
+                [("TX power fixed at 0 dBm", "node-load", []),
+                 ("TX power per neighbour", "node-load", ["-a"])]),
+}
+
+
+def layout(kind, n, spacing, rng):
+    if kind == "line":
+        return [(i * spacing, 0.0) for i in range(n)]
+    if kind == "grid":
+        side = math.ceil(math.sqrt(n))
+        return [((i % side) * spacing, (i // side) * spacing) for i in range(n)]
+    # random: uniform in a square holding about one node per spacing^2
+    side = spacing * math.sqrt(n)
+    return [(0.0, 0.0)] + [(rng.uniform(0, side), rng.uniform(0, side)) for _ in range(n - 1)]
+
+
+class Node:
+    def __init__(self, node_id, proc, log):
+        self.id = node_id
+        self.proc = proc
+        self.log = log
+        self.joined = None          # seconds from start to the first request
+        self.sent = 0
+        self.received = 0
+        self.pending = None         # time of the last unanswered request
+        self.rtts = []
+        self.radio = None           # RADIO counters printed on exit
+
+
+def reader(node, start, lock):
+    for raw in node.proc.stdout:
+        line = raw.decode(errors="replace")
+        now = time.monotonic() - start
+        node.log.write(f"{now:10.3f} {line}")
+        with lock:
+            m = RADIO.search(line)
+            if m:
+                node.radio = [float(v) for v in m.groups()]
+            elif SEND.search(line):
+                node.sent += 1
+                node.pending = now
+                if node.joined is None:
+                    node.joined = now
+            elif RESPONSE.search(line):
+                node.received += 1
+                if node.pending is not None:
+                    node.rtts.append(now - node.pending)
+                    node.pending = None
+
+
+def pct(values, p):
+    if not values:
+        return float("nan")
+    v = sorted(values)
+    return v[min(len(v) - 1, int(round((len(v) - 1) * p / 100.0)))]
+
+
+def run(args, client, flags, out):
+    """One network run. Returns the nodes, the medium's summary and the elapsed time."""
+    rng = random.Random(args.seed)
+    os.makedirs(out, exist_ok=True)
+    medium_path = os.path.join(out, "medium")
+    topo = os.path.join(out, "topology.txt")
+    with open(topo, "w") as f:
+        for i, (x, y) in enumerate(layout(args.layout, args.nodes, args.spacing, rng), 1):
+            f.write(f"{i} {x:.1f} {y:.1f}\n")
+
+    medium = subprocess.Popen([os.path.join(args.build, "sim-medium"), "-t", topo,
+                               "-m", medium_path, "-l", str(args.loss), "-s", str(args.seed)],
+                              stderr=subprocess.PIPE)
+    while not os.path.exists(medium_path):
+        if medium.poll() is not None:
+            sys.exit(medium.stderr.read().decode())
+        time.sleep(0.05)
+
+    env = dict(os.environ, SIM_SEND_INTERVAL=str(args.interval))
+    start = time.monotonic()
+    lock = threading.Lock()
+    nodes = []
+    threads = []
+    for i in range(1, args.nodes + 1):
+        exe = "node-server" if i == 1 else client
+        proc = subprocess.Popen([os.path.join(args.build, exe), "-n", str(i),
+                                 "-m", medium_path, "-s", str(args.seed * 1000 + i)] + flags,
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, env=env)
+        node = Node(i, proc, open(os.path.join(out, f"node-{i}.log"), "w"))
+        t = threading.Thread(target=reader, args=(node, start, lock), daemon=True)
+        t.start()
+        threads.append(t)
+        nodes.append(node)
+
+    try:
+        time.sleep(args.duration)
+    except KeyboardInterrupt:
+        pass
+    elapsed = time.monotonic() - start
+    for node in nodes:
+        node.proc.terminate()
+    for node, t in zip(nodes, threads):
+        node.proc.wait()
+        t.join()                    # the radio counters are the last line
+        node.log.close()
+    medium.send_signal(signal.SIGINT)
+    medium_summary = medium.communicate()[1].decode().strip().splitlines()
+    return nodes, medium_summary[-1] if medium_summary else "", elapsed
+
+
+def report(nodes, medium_summary):
+    clients = nodes[1:]
+    joined = [n.joined for n in clients if n.joined is not None]
+    sent = sum(n.sent for n in clients)
+    received = sum(n.received for n in clients)
+    rtts = [r for n in clients for r in n.rtts]
+    print(f"convergence: {len(joined)}/{len(clients)} clients reached the root,"
+          f" median {pct(joined, 50):.1f} s, max {max(joined) if joined else float('nan'):.1f} s")
+    print(f"PDR: {received}/{sent} = {received / sent if sent else float('nan'):.3f}")
+    print(f"latency: median {pct(rtts, 50) * 1000:.1f} ms, p95 {pct(rtts, 95) * 1000:.1f} ms")
+    radio = [sum(c) for c in zip(*(n.radio for n in nodes if n.radio))]
+    if radio:
+        tx, repeated, checks, busy, on_air, noack, dbm, uj = radio
+        print(f"radio: {tx:.0f} transmissions, retries {repeated / tx if tx else float('nan'):.3f}"
+              f" per transmission, CCA busy {busy / checks if checks else 0.0:.3f}"
+              f" of {checks:.0f} checks")
+        print(f"txpower: mean {dbm / on_air if on_air else float('nan'):.1f} dBm over"
+              f" {on_air:.0f} frames, {noack:.0f} unicasts without ACK,"
+              f" {uj:.1f} uJ radiated, {uj / received if received else float('nan'):.2f}"
+              f" uJ per response")
+    m = MEDIUM.search(medium_summary)
+    if m:
+        rx, lost, collisions = (int(v) for v in m.groups())
+        heard = rx + lost + collisions
+        print(f"medium: {collisions} collisions,"
+              f" {collisions / heard if heard else float('nan'):.3f} of receptions in range")
+    if medium_summary:
+        print(medium_summary)
+    return len(joined) == len(clients), received / sent if sent else 0.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-b", "--build", default="build-native", help="native build directory")
+    ap.add_argument("--scenario", choices=sorted(SCENARIOS), help="compare runs, see above")
+    ap.add_argument("-n", "--nodes", type=int, default=10)
+    ap.add_argument("--layout", choices=("grid", "line", "random"), default="grid")
+    ap.add_argument("--spacing", type=float, default=20.0, help="metres between neighbours")
+    ap.add_argument("-d", "--duration", type=float, default=600.0, help="seconds to run")
+    ap.add_argument("-i", "--interval", type=int, default=1000,
+                    help="ms between requests of node-load clients")
+    ap.add_argument("-l", "--loss", type=float, default=0.0, help="extra loss per reception")
+    ap.add_argument("-s", "--seed", type=int, default=1)
+    ap.add_argument("-o", "--out", help="directory for topology and logs (default: temporary)")
+    ap.add_argument("--min-pdr", type=float,
+                    help="fail unless every client reached the root and the PDR is at least this")
+    args = ap.parse_args()
+    runs = [("", "node-client", [])]
+    if args.scenario:
+        defaults, runs = SCENARIOS[args.scenario]
+        ap.set_defaults(**defaults)
+        args = ap.parse_args()
+
+    if args.nodes < 2:
+        sys.exit("need at least 2 nodes")
+    out = args.out or tempfile.mkdtemp(prefix="sim-rpl-")
+    failed = False
+    for k, (label, client, flags) in enumerate(runs):
+        run_out = os.path.join(out, f"run-{k + 1}") if len(runs) > 1 else out
+        nodes, medium_summary, elapsed = run(args, client, flags, run_out)
+        if label:
+            print(f"== {label}")
+        print(f"{args.nodes} nodes, {args.layout} layout, {args.spacing:g} m spacing,"
+              f" {elapsed:.0f} s, logs in {run_out}")
+        all_joined, pdr = report(nodes, medium_summary)
+        if args.min_pdr is not None and not all_joined:
+            print("FAIL: not every client reached the root")
+            failed = True
+        elif args.min_pdr is not None and pdr < args.min_pdr:
+            print(f"FAIL: PDR below {args.min_pdr:g}")
+            failed = True
+    if failed:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Convert the ESP32-C6 sniffer UART stream to PCAP-NG.
+
+The firmware (ESP32C6_RADIO_CONF_SNIFFER 1) writes framed records, see
+components/contiki-ng-esp32c6/arch/sniffer-rec.h. Frames are written with
+the IEEE 802.15.4 TAP link type so Wireshark shows channel, RSSI and LQI.
+
+  sniffer2pcapng.py /dev/ttyUSB0 -o capture.pcapng       # live, needs pyserial
+  sniffer2pcapng.py capture.bin -o capture.pcapng        # from a raw dump
+  sniffer2pcapng.py /dev/ttyUSB0 -o - | wireshark -k -i -
+"""
+import argparse
+import struct
+import sys
+import time
+
+SYNC = b"\xc5\x15"
+REC_FRAME = 1
+FLAG_FCS = 0x01
+HDR = struct.Struct("<2sBBBbBBQI")     # sync .. lost, 20 bytes
+CRC_LEN = 2
+
+LINKTYPE_IEEE802_15_4_TAP = 283
+TAP_FCS_TYPE, TAP_RSS, TAP_CHANNEL, TAP_LQI = 0, 1, 3, 10
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class Decoder:
+    """Resynchronises on the sync bytes and drops records with a bad CRC."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            i = self.buf.find(SYNC)
+            if i < 0:
+                del self.buf[:-1]
+                return
+            del self.buf[:i]
+            if len(self.buf) < HDR.size:
+                return
+            _, rtype, plen, ch, rssi, lqi, flags, ts, lost = HDR.unpack_from(self.buf)
+            end = HDR.size + plen + CRC_LEN
+            if len(self.buf) < end:
+                return
+            crc, = struct.unpack_from("<H", self.buf, end - CRC_LEN)
+            if rtype != REC_FRAME or crc16_ccitt(self.buf[2:end - CRC_LEN]) != crc:
+                self.bad += 1
+                del self.buf[:1]
+                continue
+            psdu = bytes(self.buf[HDR.size:end - CRC_LEN])
+            del self.buf[:end]
+            yield dict(channel=ch, rssi=rssi, lqi=lqi, flags=flags,
+                       timestamp=ts, lost=lost, psdu=psdu)
+
+
+def pad4(b):
+    return b + b"\0" * (-len(b) % 4)
+
+
+def block(btype, body):
+    length = 12 + len(body)
+    return struct.pack("<II", btype, length) + body + struct.pack("<I", length)
+
+
+def shb():
+    return block(0x0A0D0D0A, struct.pack("<IHHq", 0x1A2B3C4D, 1, 0, -1))
+
+
+def idb():
+    # default if_tsresol is microseconds, the same as the device timestamps
+    return block(0x00000001, struct.pack("<HHI", LINKTYPE_IEEE802_15_4_TAP, 0, 0))
+
+
+def tap_header(rec):
+    tlvs = b""
+    tlvs += struct.pack("<HHB3x", TAP_FCS_TYPE, 1, 1 if rec["flags"] & FLAG_FCS else 0)
+    tlvs += struct.pack("<HHf", TAP_RSS, 4, float(rec["rssi"]))
+    tlvs += struct.pack("<HHHBx", TAP_CHANNEL, 3, rec["channel"], 0)
+    tlvs += struct.pack("<HHB3x", TAP_LQI, 1, rec["lqi"])
+    return struct.pack("<BBH", 0, 0, 4 + len(tlvs)) + tlvs
+
+
+def epb(rec, ts_us, dropped):
+    data = tap_header(rec) + rec["psdu"]
+    body = struct.pack("<IIIII", 0, ts_us >> 32, ts_us & 0xFFFFFFFF, len(data), len(data))
+    body += pad4(data)
+    if dropped:
+        body += struct.pack("<HHQ", 4, 8, dropped)      # epb_dropcount
+        body += struct.pack("<HH", 0, 0)                 # opt_endofopt
+    return block(0x00000006, body)
+
+
+def open_input(path, baud):
+    if path == "-":
+        return sys.stdin.buffer
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial
+        return serial.Serial(path, baud, timeout=0.1)
+    return open(path, "rb")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("input", help="serial port, raw dump file, or - for stdin")
+    ap.add_argument("-o", "--output", default="-", help="PCAP-NG file, - for stdout")
+    ap.add_argument("-b", "--baud", type=int, default=921600)
+    args = ap.parse_args()
+
+    src = open_input(args.input, args.baud)
+    out = sys.stdout.buffer if args.output == "-" else open(args.output, "wb")
+    out.write(shb() + idb())
+    out.flush()
+
+    dec = Decoder()
+    base = None
+    last_lost = 0
+    frames = 0
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if hasattr(src, "in_waiting"):
+                    continue                    # serial timeout
+                break
+            for rec in dec.feed(data):
+                if base is None:
+                    # device time is us since boot, anchor it to the host clock
+                    base = int(time.time() * 1e6) - rec["timestamp"]
+                dropped = max(rec["lost"] - last_lost, 0)
+                last_lost = rec["lost"]
+                if dropped:
+                    print(f"{dropped} frames lost on the device", file=sys.stderr)
+                out.write(epb(rec, base + rec["timestamp"], dropped))
+                frames += 1
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    print(f"{frames} frames, {last_lost} lost on the device, {dec.bad} bad records",
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Host test of sniffer2pcapng.py on a sniffer UART stream.
+
+The stream comes from test/sniffer-stream.c, which builds records with the
+firmware's encoder. The test checks that the decoder recovers every good
+record whatever the read sizes, and that the PCAP-NG written by the tool
+parses back to the same frames: block structure, the TAP link type,
+channel/RSSI/LQI/FCS TLVs, relative timestamps and drop counts.
+
+  test_sniffer2pcapng.py path/to/sniffer-stream
+"""
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+
+sys.dont_write_bytecode = True
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import sniffer2pcapng  # noqa: E402
+
+STREAM_TOOL = None
+FRAMES = 40
+BAD_CRC_INDEX = 17
+
+
+def expected_frames():
+    """The contents sniffer-stream.c gives frame i, minus the corrupted one."""
+    out = []
+    for i in range(FRAMES):
+        if i == BAD_CRC_INDEX:
+            continue
+        n = 3 + (37 * i) % 125
+        out.append(dict(channel=11 + i % 16, rssi=-20 - (3 * i) % 80,
+                        lqi=(29 * i) & 0xFF, flags=1 if i % 7 == 0 else 0,
+                        timestamp=0xFFFFF000 + 1234 * i, lost=2 * (i // 4),
+                        psdu=bytes((13 * i + k) & 0xFF for k in range(n))))
+    return out
+
+
+def read_pcapng(data):
+    """Minimal little-endian PCAP-NG reader, independent of the writer."""
+    blocks = []
+    off = 0
+    while off < len(data):
+        btype, length = struct.unpack_from("<II", data, off)
+        assert length % 4 == 0 and length >= 12, f"block length {length}"
+        trailer, = struct.unpack_from("<I", data, off + length - 4)
+        assert trailer == length, "block trailer length mismatch"
+        blocks.append((btype, data[off + 8:off + length - 4]))
+        off += length
+    assert off == len(data), "trailing bytes after the last block"
+    return blocks
+
+
+def parse_options(buf):
+    opts = {}
+    off = 0
+    while off + 4 <= len(buf):
+        code, length = struct.unpack_from("<HH", buf, off)
+        if code == 0:
+            break
+        opts[code] = buf[off + 4:off + 4 + length]
+        off += 4 + length + (-length % 4)
+    return opts
+
+
+def parse_tap(data):
+    version, _, hdr_len = struct.unpack_from("<BBH", data)
+    assert version == 0
+    tlvs = {}
+    off = 4
+    while off < hdr_len:
+        t, length = struct.unpack_from("<HH", data, off)
+        tlvs[t] = data[off + 4:off + 4 + length]
+        off += 4 + length + (-length % 4)
+    assert off == hdr_len, "TLVs do not fill the TAP header"
+    return tlvs, data[hdr_len:]
+
+
+class SnifferToPcapng(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.stream = subprocess.run([STREAM_TOOL, str(FRAMES)], check=True,
+                                    stdout=subprocess.PIPE).stdout
+
+    def decode(self, chunk):
+        dec = sniffer2pcapng.Decoder()
+        got = []
+        for i in range(0, len(self.stream), chunk):
+            got.extend(dec.feed(self.stream[i:i + chunk]))
+        return got, dec
+
+    def test_decoder_any_read_size(self):
+        want = expected_frames()
+        for chunk in (1, 2, 7, 20, 23, 64, 4096):
+            with self.subTest(chunk=chunk):
+                got, dec = self.decode(chunk)
+                self.assertEqual(got, want)
+                self.assertGreaterEqual(dec.bad, 1)
+
+    def test_pcapng(self):
+        want = expected_frames()
+        with tempfile.TemporaryDirectory() as tmp:
+            raw = os.path.join(tmp, "capture.bin")
+            pcap = os.path.join(tmp, "capture.pcapng")
+            with open(raw, "wb") as f:
+                f.write(self.stream)
+            run = subprocess.run([sys.executable, sniffer2pcapng.__file__, raw, "-o", pcap],
+                                 check=True, stderr=subprocess.PIPE, text=True)
+            with open(pcap, "rb") as f:
+                blocks = read_pcapng(f.read())
+
+        summary = run.stderr.strip().splitlines()[-1]
+        self.assertTrue(summary.startswith(f"{len(want)} frames, {want[-1]['lost']} lost"),
+                        summary)
+
+        btype, body = blocks[0]
+        self.assertEqual(btype, 0x0A0D0D0A)
+        magic, major, minor = struct.unpack_from("<IHH", body)
+        self.assertEqual((magic, major, minor), (0x1A2B3C4D, 1, 0))
+        btype, body = blocks[1]
+        self.assertEqual(btype, 0x00000001)
+        linktype, = struct.unpack_from("<H", body)
+        self.assertEqual(linktype, sniffer2pcapng.LINKTYPE_IEEE802_15_4_TAP)
+
+        epbs = blocks[2:]
+        self.assertEqual(len(epbs), len(want))
+        first_ts = None
+        last_lost = 0
+        for (btype, body), rec in zip(epbs, want):
+            self.assertEqual(btype, 0x00000006)
+            iface, ts_hi, ts_lo, cap_len, orig_len = struct.unpack_from("<IIIII", body)
+            self.assertEqual(iface, 0)
+            self.assertEqual(cap_len, orig_len)
+            ts = ts_hi << 32 | ts_lo
+            if first_ts is None:
+                first_ts = ts
+            # the tool anchors the first frame to the host clock, the
+            # spacing must be the device's
+            self.assertEqual(ts - first_ts, rec["timestamp"] - want[0]["timestamp"])
+
+            data = body[20:20 + cap_len]
+            tlvs, psdu = parse_tap(data)
+            self.assertEqual(psdu, rec["psdu"])
+            self.assertEqual(tlvs[sniffer2pcapng.TAP_FCS_TYPE][0], rec["flags"] & 1)
+            self.assertEqual(struct.unpack("<f", tlvs[sniffer2pcapng.TAP_RSS])[0], rec["rssi"])
+            self.assertEqual(struct.unpack("<HB", tlvs[sniffer2pcapng.TAP_CHANNEL]),
+                             (rec["channel"], 0))
+            self.assertEqual(tlvs[sniffer2pcapng.TAP_LQI][0], rec["lqi"])
+
+            opts = parse_options(body[20 + cap_len + (-cap_len % 4):])
+            dropped = rec["lost"] - last_lost
+            last_lost = rec["lost"]
+            if dropped:
+                self.assertEqual(struct.unpack("<Q", opts[4])[0], dropped)
+            else:
+                self.assertNotIn(4, opts)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    STREAM_TOOL = sys.argv.pop(1)
+    unittest.main()